@@ -0,0 +1,158 @@
+/*
+ * Instruction set independent part of the vector aggregates.
+ *
+ * Like scan_kernels_simd.h this file has no include guard: aggregates.h includes it once per instruction set, inside
+ * a namespace that is compiled for that instruction set and provides VecT<T>. The kernels use GCC vector extensions
+ * as wide as VecT, which the compiler maps to the instruction set of the namespace.
+ */
+
+static constexpr size_t VECTOR_BYTES = sizeof(VecT<int8_t>);
+
+// Vector of T, as wide as VecT unless *Bytes* says otherwise
+template <class T, size_t Bytes = VECTOR_BYTES>
+struct Vec {
+    typedef T type __attribute__((vector_size(Bytes)));
+};
+
+// Adds the lanes of *v* to *acc*, widened to Wide. A vector of T takes sizeof(Wide) / sizeof(T) vectors of Wide.
+template <class Wide, class T>
+inline void addWidened(typename Vec<Wide>::type &acc, typename Vec<T>::type v) {
+    constexpr size_t parts = sizeof(Wide) / sizeof(T);
+    typedef typename Vec<T, VECTOR_BYTES / parts>::type Part;
+    for (size_t p = 0; p < parts; p++) {
+        Part part;
+        memcpy(&part, reinterpret_cast<const char *>(&v) + p * sizeof(Part), sizeof(Part));
+        acc += __builtin_convertvector(part, typename Vec<Wide>::type);
+    }
+}
+
+template <class Wide>
+inline int64_t sumLanes(typename Vec<Wide>::type acc) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < VECTOR_BYTES / sizeof(Wide); i++) sum += acc[i];
+    return sum;
+}
+
+template <class T>
+inline typename Vec<T>::type broadcast(T value) {
+    typename Vec<T>::type v = {};
+    return v + value;
+}
+
+// Each filter returns all ones in the lanes to aggregate and zeros in the others
+
+template <class T>
+struct NoFilter {
+    inline typename Vec<T>::type operator()(typename Vec<T>::type) const { return broadcast<T>(-1); }
+};
+
+template <class T>
+struct EqualFilter {
+    inline typename Vec<T>::type operator()(typename Vec<T>::type v) const { return v == needle; }
+    typename Vec<T>::type needle;
+};
+
+template <class T>
+struct BetweenFilter {
+    inline typename Vec<T>::type operator()(typename Vec<T>::type v) const { return (v >= low) & (v <= high); }
+    typename Vec<T>::type low;
+    typename Vec<T>::type high;
+};
+
+// IN-lists up to SIMD_IN_LIST_LIMIT values, one compare per value
+template <class T>
+struct ListFilter {
+    explicit ListFilter(const Predicate<T> &predicate) : count(predicate.values.size()) {
+        for (size_t i = 0; i < count; i++) values[i] = broadcast<T>(predicate.values[i]);
+    }
+
+    inline typename Vec<T>::type operator()(typename Vec<T>::type v) const {
+        typename Vec<T>::type matches = {};
+        for (size_t i = 0; i < count; i++) matches |= v == values[i];
+        return matches;
+    }
+
+    size_t count;
+    typename Vec<T>::type values[SIMD_IN_LIST_LIMIT];
+};
+
+/*
+ * Aggregates the rows of [begin, end) that pass the filter. Sums of 8 and 16 bit values go through 32 bit lanes, which
+ * are added to the 64 bit lanes before they can overflow.
+ */
+template <Aggregate Op, class T, class Filter>
+AggregateResult aggregateColumn(const T *column, size_t begin, size_t end, const Filter &filter) {
+    typedef typename Vec<T>::type V;
+    typedef typename std::conditional<sizeof(T) <= 2, int32_t, int64_t>::type Narrow;
+    const size_t lanes = VECTOR_BYTES / sizeof(T);
+    // 32 bit lanes take at most 4 * 2^15 per vector
+    const size_t flushInterval = 1 << 14;
+
+    typename Vec<int64_t>::type sums = {}, counts = {};
+    typename Vec<Narrow>::type narrowSums = {}, narrowCounts = {};
+    V minimum = broadcast<T>(std::numeric_limits<T>::max());
+    V maximum = broadcast<T>(std::numeric_limits<T>::min());
+    size_t j = begin, vectors = 0;
+    for (; j + lanes <= end; j += lanes) {
+        V v;
+        memcpy(&v, column + j, sizeof(V));
+        V keep = filter(v);
+        addWidened<Narrow, T>(narrowCounts, keep & 1);
+        if (Op == Aggregate::Sum || Op == Aggregate::Avg) {
+            addWidened<Narrow, T>(narrowSums, v & keep);
+        } else if (Op == Aggregate::Min) {
+            minimum = (keep & (v < minimum)) ? v : minimum;
+        } else {
+            maximum = (keep & (v > maximum)) ? v : maximum;
+        }
+        if (sizeof(Narrow) < 8 && ++vectors == flushInterval) {
+            addWidened<int64_t, Narrow>(sums, narrowSums);
+            addWidened<int64_t, Narrow>(counts, narrowCounts);
+            narrowSums = narrowCounts = typename Vec<Narrow>::type{};
+            vectors = 0;
+        }
+    }
+    addWidened<int64_t, Narrow>(sums, narrowSums);
+    addWidened<int64_t, Narrow>(counts, narrowCounts);
+
+    AggregateResult result;
+    result.sum = sumLanes<int64_t>(sums);
+    result.count = (uint64_t) sumLanes<int64_t>(counts);
+    for (size_t i = 0; i < lanes; i++) {
+        result.min = std::min<int64_t>(result.min, minimum[i]);
+        result.max = std::max<int64_t>(result.max, maximum[i]);
+    }
+    // the lanes of an empty filter still hold the identities, which the tail cannot undo
+    if (result.count == 0) result = AggregateResult();
+    for (; j < end; j++) {
+        T value = column[j];
+        V single = broadcast<T>(value);
+        if (filter(single)[0]) result.add(value);
+    }
+    return result;
+}
+
+template <Aggregate Op, class T>
+AggregateResult aggregateColumn(const T *column, size_t begin, size_t end, bool filtered,
+                                const Predicate<T> &predicate) {
+    if (!filtered) return aggregateColumn<Op>(column, begin, end, NoFilter<T>());
+    switch (predicate.type()) {
+        case PredicateType::Equal:
+            return aggregateColumn<Op>(column, begin, end, EqualFilter<T>{broadcast<T>(predicate.low)});
+        case PredicateType::Between:
+            return aggregateColumn<Op>(column, begin, end,
+                                       BetweenFilter<T>{broadcast<T>(predicate.low), broadcast<T>(predicate.high)});
+        default:
+            return aggregateColumn<Op>(column, begin, end, ListFilter<T>(predicate));
+    }
+}
+
+template <class T>
+AggregateResult aggregateColumn(Aggregate aggregate, const T *column, size_t begin, size_t end, bool filtered,
+                                const Predicate<T> &predicate) {
+    switch (aggregate) {
+        case Aggregate::Min: return aggregateColumn<Aggregate::Min>(column, begin, end, filtered, predicate);
+        case Aggregate::Max: return aggregateColumn<Aggregate::Max>(column, begin, end, filtered, predicate);
+        default: return aggregateColumn<Aggregate::Sum>(column, begin, end, filtered, predicate);
+    }
+}
@@ -0,0 +1,201 @@
+#ifndef AGGREGATES_H
+#define AGGREGATES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include "predicate.h"
+#include "scan_kernels.h"
+
+/*
+ * Aggregates over a scanned column: SUM, MIN, MAX and AVG of all rows, of the rows that satisfy the scan predicate,
+ * or grouped by a key column of few distinct values.
+ *
+ * Sums are kept in 64 bit. The vector kernels add 8 and 16 bit values in 32 bit lanes first, so a vector holds as many
+ * partial sums as possible, and move them to 64 bit lanes before they can overflow.
+ */
+
+enum class Aggregate { None, Sum, Min, Max, Avg };
+
+inline bool parseAggregate(const std::string &name, Aggregate &aggregate) {
+    if (name == "none") aggregate = Aggregate::None;
+    else if (name == "sum") aggregate = Aggregate::Sum;
+    else if (name == "min") aggregate = Aggregate::Min;
+    else if (name == "max") aggregate = Aggregate::Max;
+    else if (name == "avg") aggregate = Aggregate::Avg;
+    else return false;
+    return true;
+}
+
+inline std::string aggregateName(Aggregate aggregate) {
+    switch (aggregate) {
+        case Aggregate::None: return "none";
+        case Aggregate::Sum: return "sum";
+        case Aggregate::Min: return "min";
+        case Aggregate::Max: return "max";
+        case Aggregate::Avg: return "avg";
+    }
+    return "unknown";
+}
+
+// State of an aggregate over some rows, AVG is the sum divided by the count
+struct AggregateResult {
+    inline void add(int64_t value) {
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+        count++;
+    }
+
+    void merge(const AggregateResult &other) {
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        count += other.count;
+    }
+
+    int64_t sum = 0;
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = std::numeric_limits<int64_t>::min();
+    uint64_t count = 0;
+};
+
+/* Scalar kernels */
+
+template <class T>
+struct AllMatch {
+    inline bool operator()(T) const { return true; }
+};
+
+// Only updates the state the aggregate needs, the others keep their initial values
+template <Aggregate Op, class T, class Match>
+SCALAR_KERNEL AggregateResult aggregateScalar(const T *column, size_t begin, size_t end, const Match &match) {
+    int64_t sum = 0, minimum = std::numeric_limits<int64_t>::max(), maximum = std::numeric_limits<int64_t>::min();
+    uint64_t count = 0;
+    NO_VECTORIZE
+    for (size_t j = begin; j < end; j++) {
+        int64_t value = column[j];
+        bool matches = match(column[j]);
+        count += matches;
+        if (Op == Aggregate::Min) {
+            minimum = matches && value < minimum ? value : minimum;
+        } else if (Op == Aggregate::Max) {
+            maximum = matches && value > maximum ? value : maximum;
+        } else {
+            sum += matches ? value : 0;
+        }
+    }
+    AggregateResult result;
+    result.sum = sum;
+    result.min = minimum;
+    result.max = maximum;
+    result.count = count;
+    return result;
+}
+
+template <Aggregate Op, class T>
+AggregateResult aggregateScalar(const T *column, size_t begin, size_t end, bool filtered,
+                                const Predicate<T> &predicate) {
+    if (!filtered) return aggregateScalar<Op>(column, begin, end, AllMatch<T>());
+    switch (predicate.type()) {
+        case PredicateType::Equal:
+            return aggregateScalar<Op>(column, begin, end, EqualMatch<T>{predicate.low});
+        case PredicateType::Between:
+            return aggregateScalar<Op>(column, begin, end, BetweenMatch<T>{predicate.low, predicate.high});
+        default:
+            return aggregateScalar<Op>(column, begin, end, LookupMatch<T>{predicate});
+    }
+}
+
+template <class T>
+AggregateResult aggregateScalar(Aggregate aggregate, const T *column, size_t begin, size_t end, bool filtered,
+                                const Predicate<T> &predicate) {
+    switch (aggregate) {
+        case Aggregate::Min: return aggregateScalar<Aggregate::Min>(column, begin, end, filtered, predicate);
+        case Aggregate::Max: return aggregateScalar<Aggregate::Max>(column, begin, end, filtered, predicate);
+        default: return aggregateScalar<Aggregate::Sum>(column, begin, end, filtered, predicate);
+    }
+}
+
+/*
+ * GROUP BY: adds row j to groups[keys[j]]. The table belongs to the calling thread and is small enough to stay in the
+ * L1 cache, the tables of all threads are merged once the scan is done.
+ */
+template <class T, class Match>
+SCALAR_KERNEL void aggregateGroups(const uint32_t *keys, const T *column, size_t begin, size_t end,
+                                   const Match &match, AggregateResult *groups) {
+    NO_VECTORIZE
+    for (size_t j = begin; j < end; j++) {
+        if (match(column[j])) groups[keys[j]].add(column[j]);
+    }
+}
+
+template <class T>
+void aggregateGroups(const uint32_t *keys, const T *column, size_t begin, size_t end, bool filtered,
+                     const Predicate<T> &predicate, AggregateResult *groups) {
+    if (!filtered) return aggregateGroups(keys, column, begin, end, AllMatch<T>(), groups);
+    switch (predicate.type()) {
+        case PredicateType::Equal:
+            return aggregateGroups(keys, column, begin, end, EqualMatch<T>{predicate.low}, groups);
+        case PredicateType::Between:
+            return aggregateGroups(keys, column, begin, end, BetweenMatch<T>{predicate.low, predicate.high}, groups);
+        default:
+            return aggregateGroups(keys, column, begin, end, LookupMatch<T>{predicate}, groups);
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+
+BEGIN_TARGET("sse4.2,popcnt")
+namespace sse {
+#include "aggregate_simd.h"
+} // namespace sse
+END_TARGET
+
+BEGIN_TARGET("avx2,bmi2,popcnt")
+namespace avx2 {
+#include "aggregate_simd.h"
+} // namespace avx2
+END_TARGET
+
+BEGIN_TARGET("avx512f,avx512bw,popcnt")
+namespace avx512 {
+#include "aggregate_simd.h"
+} // namespace avx512
+END_TARGET
+
+#endif // HAVE_X86_KERNELS
+
+#ifdef HAVE_VSX_KERNELS
+namespace vsx {
+#include "aggregate_simd.h"
+} // namespace vsx
+#endif // HAVE_VSX_KERNELS
+
+/*
+ * Aggregates rows [begin, end) of a contiguous column, only the rows that satisfy the predicate if *filtered*. IN-lists
+ * that need a lookup have no vector form and take the scalar kernel.
+ */
+template <class T>
+AggregateResult aggregateColumn(ScanKernel kernel, Aggregate aggregate, const T *column, size_t begin, size_t end,
+                                bool filtered, const Predicate<T> &predicate) {
+    if (filtered && predicate.usesLookup()) kernel = ScanKernel::Scalar;
+    switch (kernel) {
+#ifdef HAVE_X86_KERNELS
+        case ScanKernel::SSE: return sse::aggregateColumn(aggregate, column, begin, end, filtered, predicate);
+        case ScanKernel::AVX2: return avx2::aggregateColumn(aggregate, column, begin, end, filtered, predicate);
+        case ScanKernel::AVX512: return avx512::aggregateColumn(aggregate, column, begin, end, filtered, predicate);
+#endif
+#ifdef HAVE_VSX_KERNELS
+        case ScanKernel::VSX: return vsx::aggregateColumn(aggregate, column, begin, end, filtered, predicate);
+#endif
+        default: return aggregateScalar(aggregate, column, begin, end, filtered, predicate);
+    }
+}
+
+#endif // AGGREGATES_H
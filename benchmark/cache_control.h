@@ -0,0 +1,212 @@
+#ifndef CACHE_CONTROL_H
+#define CACHE_CONTROL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "column_memory.h"
+#include "worker_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/*
+ * Cache state a sample starts in.
+ *
+ *   warm      the default: the iterations of a sample run back to back, so all but the first find the data of the
+ *             previous one in the caches it fits in.
+ *   cold      before every pass each thread flushes its share of the working set (clflushopt or clflush on x86, dcbf
+ *             on POWER), so the pass reads everything from memory. Without a flush instruction it writes to an
+ *             eviction buffer instead, which only pushes the data out of the caches the thread shares.
+ *   llc-only  each thread reads its share of the working set and then evicts its private caches with a buffer of
+ *             twice their size, so the pass finds the data in the last level cache as far as it fits there.
+ *
+ * In cold and llc-only a sample is a single pass. The working set is every ColumnBuffer that is allocated, see
+ * LiveBuffers. The threads split each buffer into equal shares, which need not be the rows they scan: flushes act on
+ * all caches of the machine, and with llc-only the share lands in the last level cache of the thread that read it.
+ */
+
+enum class CacheState { Warm, Cold, LlcOnly };
+
+inline bool parseCacheState(const std::string &name, CacheState &state) {
+    if (name == "warm") state = CacheState::Warm;
+    else if (name == "cold") state = CacheState::Cold;
+    else if (name == "llc-only") state = CacheState::LlcOnly;
+    else return false;
+    return true;
+}
+
+inline std::string cacheStateName(CacheState state) {
+    switch (state) {
+        case CacheState::Warm: return "warm";
+        case CacheState::Cold: return "cold";
+        case CacheState::LlcOnly: return "llc-only";
+    }
+    return "unknown";
+}
+
+#ifdef _ARCH_PPC64
+static const size_t FLUSH_LINE_BYTES = 128;
+#else
+static const size_t FLUSH_LINE_BYTES = CACHE_LINE_BYTES;
+#endif
+
+// Assumed where sysfs does not describe the caches, e.g. in some POWER LPARs
+static const size_t DEFAULT_LLC_BYTES = 64 << 20;
+static const size_t DEFAULT_PRIVATE_CACHE_BYTES = 1 << 20;
+
+// A data or unified cache of a CPU, from /sys/devices/system/cpu/cpuN/cache
+struct CacheLevel {
+    int level;
+    size_t bytes;
+    std::vector<int> sharedCpus;
+};
+
+inline std::vector<CacheLevel> cpuCaches(int cpu) {
+    std::vector<CacheLevel> caches;
+    auto directory = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index";
+    for (int index = 0; ; index++) {
+        std::ifstream level(directory + std::to_string(index) + "/level");
+        std::ifstream type(directory + std::to_string(index) + "/type");
+        std::ifstream size(directory + std::to_string(index) + "/size");
+        std::ifstream shared(directory + std::to_string(index) + "/shared_cpu_list");
+        CacheLevel cache;
+        std::string typeName, sizeText, cpuList;
+        if (!(level >> cache.level) || !(type >> typeName) || !(size >> sizeText)) break;
+        if (typeName == "Instruction") continue;
+        // e.g. 32K or 36608K
+        char *unit;
+        cache.bytes = strtoull(sizeText.c_str(), &unit, 10);
+        if (*unit == 'K') cache.bytes <<= 10;
+        else if (*unit == 'M') cache.bytes <<= 20;
+        if (!(shared >> cpuList) || !parseCpuList(cpuList, cache.sharedCpus)) cache.sharedCpus = {cpu};
+        caches.push_back(cache);
+    }
+    return caches;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+inline bool hasClflushopt() {
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 23));
+}
+
+__attribute__((target("clflushopt")))
+inline void flushLinesOpt(const char *begin, const char *end) {
+    for (auto line = begin; line < end; line += FLUSH_LINE_BYTES) _mm_clflushopt((void *) line);
+}
+#endif
+
+/*
+ * Writes the lines of [begin, end) back to memory and drops them from every cache. Returns false where there is no
+ * instruction for it.
+ */
+inline bool flushLines(const char *begin, const char *end) {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool optimized = hasClflushopt();
+    // clflushopt is only ordered by fences, clflush also with the other flushes of the thread
+    if (optimized) flushLinesOpt(begin, end);
+    else for (auto line = begin; line < end; line += FLUSH_LINE_BYTES) _mm_clflush(line);
+    _mm_mfence();
+    return true;
+#elif defined(_ARCH_PPC64)
+    for (auto line = begin; line < end; line += FLUSH_LINE_BYTES) {
+        __asm__ __volatile__("dcbf 0,%0" : : "r"(line) : "memory");
+    }
+    __asm__ __volatile__("sync" : : : "memory");
+    return true;
+#else
+    (void) begin;
+    (void) end;
+    return false;
+#endif
+}
+
+/*
+ * Puts the caches of one thread into a CacheState before a pass. The eviction buffer holds twice the last level cache
+ * divided by the threads of the pool that share it, but at least twice the private caches. It is allocated by the
+ * thread that uses it, so it is local to it.
+ */
+class CacheControl {
+public:
+    // *cpu* is the CPU of the thread, *poolCpus* those of all threads
+    CacheControl(int cpu, const std::vector<int> &poolCpus) : controlledCpu(cpu) {
+        size_t llcBytes = DEFAULT_LLC_BYTES, privateCacheBytes = DEFAULT_PRIVATE_CACHE_BYTES;
+        int sharers = 1;
+        auto caches = cpuCaches(cpu);
+        if (!caches.empty()) {
+            const CacheLevel *llc = &caches[0];
+            for (auto &cache: caches) {
+                if (cache.level > llc->level) llc = &cache;
+            }
+            llcBytes = llc->bytes;
+            privateCacheBytes = 0;
+            for (auto &cache: caches) {
+                if (cache.level < llc->level) privateCacheBytes += cache.bytes;
+            }
+            sharers = (int) std::count_if(poolCpus.begin(), poolCpus.end(), [&](int poolCpu) {
+                return std::find(llc->sharedCpus.begin(), llc->sharedCpus.end(), poolCpu) != llc->sharedCpus.end();
+            });
+        }
+        privateBytes = 2 * privateCacheBytes;
+        buffer.assign(std::max(2 * llcBytes / std::max(sharers, 1), privateBytes) / sizeof(uint64_t), 0);
+    }
+
+    CacheControl(const CacheControl &) = delete;
+    CacheControl &operator=(const CacheControl &) = delete;
+
+    int cpu() const { return controlledCpu; }
+    size_t evictionBytes() const { return buffer.size() * sizeof(uint64_t); }
+
+    // Brings the caches into *state* for a pass of the thread *threadId* of *threadCount*
+    void prepare(CacheState state, int threadId, int threadCount) {
+        if (state == CacheState::Cold) {
+            for (auto &range: LiveBuffers::snapshot()) {
+                auto share = this->share(range, threadId, threadCount);
+                if (!flushLines(share.first, share.second)) {
+                    evict(evictionBytes());
+                    break;
+                }
+            }
+        } else if (state == CacheState::LlcOnly) {
+            for (auto &range: LiveBuffers::snapshot()) {
+                auto share = this->share(range, threadId, threadCount);
+                for (auto line = share.first; line < share.second; line += FLUSH_LINE_BYTES) {
+                    (void) *reinterpret_cast<const volatile char *>(line);
+                }
+            }
+            evict(privateBytes);
+        }
+    }
+
+private:
+    // Writes to every line of the first *bytes* of the buffer, so they replace whatever the caches held
+    void evict(size_t bytes) {
+        const size_t stride = CACHE_LINE_BYTES / sizeof(uint64_t);
+        for (size_t i = 0; i < bytes / sizeof(uint64_t); i += stride) buffer[i]++;
+        __asm__ __volatile__("" : : "r"(buffer.data()) : "memory");
+    }
+
+    // Part [begin, end) of *range* that *threadId* takes care of, in whole lines
+    static std::pair<const char *, const char *> share(const LiveBuffers::Range &range, int threadId,
+                                                       int threadCount) {
+        size_t lines = (range.second + FLUSH_LINE_BYTES - 1) / FLUSH_LINE_BYTES;
+        auto start = reinterpret_cast<uintptr_t>(range.first) & ~(uintptr_t) (FLUSH_LINE_BYTES - 1);
+        auto first = reinterpret_cast<const char *>(start + lines * threadId / threadCount * FLUSH_LINE_BYTES);
+        auto last = reinterpret_cast<const char *>(start + lines * (threadId + 1) / threadCount * FLUSH_LINE_BYTES);
+        return {first, std::min(last, range.first + range.second)};
+    }
+
+    int controlledCpu;
+    std::vector<uint64_t> buffer;
+    size_t privateBytes; // twice the caches below the last level
+};
+
+#endif // CACHE_CONTROL_H
@@ -0,0 +1,239 @@
+#ifndef COLUMN_FILE_H
+#define COLUMN_FILE_H
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Columns in files, for scans of persisted data that may be larger than memory.
+ *
+ * A column file starts with a header of COLUMN_FILE_HEADER_BYTES: a magic line and a key that describes how the data
+ * was generated, followed by the raw values. The header is written last, once the data is on disk, so a file whose
+ * generation was interrupted is never reused. A scan reads the file in one of these ways:
+ *
+ *   mmap      maps its part for the pass with MADV_SEQUENTIAL and faults the pages in as it goes
+ *   willneed  the same with MADV_WILLNEED, which starts reading the whole part ahead of the scan
+ *   populate  maps its part with MAP_POPULATE, which returns once every page is in
+ *   pread     reads chunks into two buffers on a reader thread of its own, and scans one while the next is read
+ *
+ * There is no asynchronous access through io_uring, which would need liburing.
+ *
+ * A cold page cache drops the part of every thread with POSIX_FADV_DONTNEED before a pass, so it comes from the disk.
+ * The pread buffers are placed like the tables of the other modes, mapped pages lie wherever the page cache put them.
+ */
+
+enum class FileAccess { Mmap, WillNeed, Populate, Pread };
+
+inline bool parseFileAccess(const std::string &name, FileAccess &access) {
+    if (name == "mmap") access = FileAccess::Mmap;
+    else if (name == "willneed") access = FileAccess::WillNeed;
+    else if (name == "populate") access = FileAccess::Populate;
+    else if (name == "pread") access = FileAccess::Pread;
+    else return false;
+    return true;
+}
+
+inline std::string fileAccessName(FileAccess access) {
+    switch (access) {
+        case FileAccess::Mmap: return "mmap";
+        case FileAccess::WillNeed: return "willneed";
+        case FileAccess::Populate: return "populate";
+        case FileAccess::Pread: return "pread";
+    }
+    return "unknown";
+}
+
+enum class PageCache { Warm, Cold };
+
+inline bool parsePageCache(const std::string &name, PageCache &state) {
+    if (name == "warm") state = PageCache::Warm;
+    else if (name == "cold") state = PageCache::Cold;
+    else return false;
+    return true;
+}
+
+inline std::string pageCacheName(PageCache state) {
+    return state == PageCache::Warm ? "warm" : "cold";
+}
+
+// A multiple of every page size, so the parts of the threads can be mapped at their offset
+static const size_t COLUMN_FILE_HEADER_BYTES = 64 << 10;
+// Of a pread, and the part of a scan after which it has a first result
+static const size_t FILE_CHUNK_BYTES = 1 << 20;
+static const char COLUMN_FILE_MAGIC[] = "scan benchmark column\n";
+
+// 64 bit FNV-1a, a hash that is the same on every platform, for the file names
+inline uint64_t fnv1a(const std::string &text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c: text) hash = (hash ^ c) * 0x100000001b3ull;
+    return hash;
+}
+
+class ColumnFile {
+public:
+    // Opens *path* if its header carries *key* and it holds *bytes* of data, else creates it, see created()
+    ColumnFile(const std::string &path, const std::string &key, size_t bytes) : key(key), bytes(bytes) {
+        if (key.size() + sizeof(COLUMN_FILE_MAGIC) >= COLUMN_FILE_HEADER_BYTES) {
+            errorText = "key too long";
+            return;
+        }
+        fd = open(path.c_str(), O_RDWR);
+        struct stat status;
+        if (fd >= 0 && fstat(fd, &status) == 0 && (size_t) status.st_size == COLUMN_FILE_HEADER_BYTES + bytes &&
+            header() == COLUMN_FILE_MAGIC + key) {
+            return;
+        }
+        if (fd >= 0) close(fd);
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, (off_t) (COLUMN_FILE_HEADER_BYTES + bytes)) != 0) {
+            errorText = "cannot create " + path + ": " + strerror(errno);
+            return;
+        }
+        isNew = true;
+    }
+
+    ~ColumnFile() {
+        if (fd >= 0) close(fd);
+    }
+
+    ColumnFile(const ColumnFile &) = delete;
+    ColumnFile &operator=(const ColumnFile &) = delete;
+
+    bool ok() const { return errorText.empty(); }
+    const std::string &error() const { return errorText; }
+    bool created() const { return isNew; }
+    int descriptor() const { return fd; }
+
+    // The data of a created file, to generate it into, nullptr if it cannot be mapped
+    char *mapForWriting() {
+        void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, COLUMN_FILE_HEADER_BYTES);
+        return data == MAP_FAILED ? nullptr : static_cast<char *>(data);
+    }
+
+    // Writes the data back, then the header, so the file is reused from now on
+    bool finish(char *data) {
+        bool written = msync(data, bytes, MS_SYNC) == 0;
+        munmap(data, bytes);
+        auto header = COLUMN_FILE_MAGIC + key;
+        written = written && pwrite(fd, header.c_str(), header.size() + 1, 0) == (ssize_t) header.size() + 1;
+        return written && fsync(fd) == 0;
+    }
+
+private:
+    std::string header() const {
+        char text[COLUMN_FILE_HEADER_BYTES] = {};
+        if (pread(fd, text, sizeof(text) - 1, 0) < 0) return "";
+        return text;
+    }
+
+    std::string key;
+    size_t bytes;
+    int fd = -1;
+    bool isNew = false;
+    std::string errorText;
+};
+
+/*
+ * Maps [offset, offset + bytes) of the data of a column file read-only for *access*, nullptr if that fails. *offset*
+ * is a multiple of COLUMN_FILE_HEADER_BYTES.
+ */
+inline const char *mapColumnPart(int fd, size_t offset, size_t bytes, FileAccess access) {
+    int flags = MAP_SHARED | (access == FileAccess::Populate ? MAP_POPULATE : 0);
+    void *data = mmap(nullptr, bytes, PROT_READ, flags, fd, (off_t) (COLUMN_FILE_HEADER_BYTES + offset));
+    if (data == MAP_FAILED) return nullptr;
+    if (access == FileAccess::Mmap) madvise(data, bytes, MADV_SEQUENTIAL);
+    else if (access == FileAccess::WillNeed) madvise(data, bytes, MADV_WILLNEED);
+    return static_cast<const char *>(data);
+}
+
+// Drops [offset, offset + bytes) of the data from the page cache, as far as no process maps it
+inline void dropColumnPart(int fd, size_t offset, size_t bytes) {
+    posix_fadvise(fd, (off_t) (COLUMN_FILE_HEADER_BYTES + offset), (off_t) bytes, POSIX_FADV_DONTNEED);
+}
+
+// Reads chunks of the data of a column file on a thread of its own, one at a time
+class ChunkReader {
+public:
+    explicit ChunkReader(int fd) : fd(fd), reader([this]() { run(); }) {}
+
+    ~ChunkReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        reader.join();
+    }
+
+    ChunkReader(const ChunkReader &) = delete;
+    ChunkReader &operator=(const ChunkReader &) = delete;
+
+    // Starts reading *bytes* of the data at *offset* into *buffer*, after the previous read was waited for
+    void start(char *buffer, size_t bytes, size_t offset) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            request = {buffer, bytes, offset};
+            pending = true;
+            succeeded = false;
+        }
+        changed.notify_all();
+    }
+
+    // Waits for the read that was started last, false if it failed
+    bool wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !pending; });
+        return succeeded;
+    }
+
+private:
+    struct Request {
+        char *buffer;
+        size_t bytes;
+        size_t offset;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return pending || stopping; });
+            if (stopping) return;
+            auto current = request;
+            lock.unlock();
+            size_t done = 0;
+            while (done < current.bytes) {
+                ssize_t read = pread(fd, current.buffer + done, current.bytes - done,
+                                     (off_t) (COLUMN_FILE_HEADER_BYTES + current.offset + done));
+                if (read <= 0) break;
+                done += read;
+            }
+            lock.lock();
+            succeeded = done == current.bytes;
+            pending = false;
+            changed.notify_all();
+        }
+    }
+
+    int fd;
+    std::mutex mutex;
+    std::condition_variable changed;
+    Request request{};
+    bool pending = false;
+    bool succeeded = false;
+    bool stopping = false;
+    std::thread reader; // last, it runs as soon as it is constructed
+};
+
+#endif // COLUMN_FILE_H
@@ -0,0 +1,194 @@
+#ifndef COLUMN_MEMORY_H
+#define COLUMN_MEMORY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <linux/mman.h>
+#include <sys/mman.h>
+
+/*
+ * Memory of the scanned columns and result buffers.
+ *
+ * Memory is mapped but not touched on allocation, so a memory policy or the first thread that writes a page decides
+ * where the page ends up, and it is zero-filled by the kernel. The page mode picks the page size: large columns
+ * otherwise spend a good part of a scan on address translation.
+ */
+
+static const size_t CACHE_LINE_BYTES = 64;
+
+enum class PageMode { Default, Small, Transparent, Huge2M, Huge1G, Huge16M };
+
+inline bool parsePageMode(const std::string &name, PageMode &mode) {
+    if (name == "default") mode = PageMode::Default;
+    else if (name == "small") mode = PageMode::Small;
+    else if (name == "thp") mode = PageMode::Transparent;
+    else if (name == "2m") mode = PageMode::Huge2M;
+    else if (name == "1g") mode = PageMode::Huge1G;
+    else if (name == "16m") mode = PageMode::Huge16M;
+    else return false;
+    return true;
+}
+
+inline std::string pageModeName(PageMode mode) {
+    switch (mode) {
+        case PageMode::Default: return "default";
+        case PageMode::Small: return "small";
+        case PageMode::Transparent: return "thp";
+        case PageMode::Huge2M: return "2m";
+        case PageMode::Huge1G: return "1g";
+        case PageMode::Huge16M: return "16m";
+    }
+    return "unknown";
+}
+
+inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * Page-aligned anonymous mappings:
+ *   default  whatever the system does, usually 4 KiB pages (64 KiB on POWER) plus THP if it is set to "always"
+ *   small    base pages only, transparent huge pages are switched off for the mapping
+ *   thp      transparent huge pages, the mapping is 2 MiB aligned so that every part of it can be backed by them
+ *   2m, 1g   hugetlbfs pages, which have to be reserved first (vm.nr_hugepages or the kernel command line)
+ *   16m      hugetlbfs pages of POWER's hash MMU
+ */
+class ColumnAllocator {
+public:
+    static const size_t THP_BYTES = 2ul << 20;
+
+    // Returns the usable memory, *mapping* and *mappedBytes* are what deallocate() needs. Throws std::bad_alloc.
+    static void *allocate(size_t bytes, PageMode mode, void *&mapping, size_t &mappedBytes) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        mappedBytes = alignUp(bytes, hugePageBytes(mode));
+        switch (mode) {
+            case PageMode::Huge2M: flags |= MAP_HUGETLB | MAP_HUGE_2MB; break;
+            case PageMode::Huge1G: flags |= MAP_HUGETLB | MAP_HUGE_1GB; break;
+            case PageMode::Huge16M: flags |= MAP_HUGETLB | (24 << MAP_HUGE_SHIFT); break;
+            // whole huge pages, and room to align the start
+            case PageMode::Transparent: mappedBytes = alignUp(bytes, THP_BYTES) + THP_BYTES; break;
+            default: break;
+        }
+        mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (mapping == MAP_FAILED) throw std::bad_alloc();
+
+        auto memory = static_cast<char *>(mapping);
+        if (mode == PageMode::Transparent) {
+            memory = reinterpret_cast<char *>(alignUp(reinterpret_cast<uintptr_t>(memory), THP_BYTES));
+            madvise(memory, alignUp(bytes, THP_BYTES), MADV_HUGEPAGE);
+        } else if (mode == PageMode::Small) {
+            madvise(memory, mappedBytes, MADV_NOHUGEPAGE);
+        }
+        return memory;
+    }
+
+    static void deallocate(void *mapping, size_t mappedBytes) {
+        munmap(mapping, mappedBytes);
+    }
+
+    // Granularity of hugetlbfs mappings, 1 for the modes with base pages
+    static size_t hugePageBytes(PageMode mode) {
+        switch (mode) {
+            case PageMode::Huge2M: return 2ul << 20;
+            case PageMode::Huge1G: return 1ul << 30;
+            case PageMode::Huge16M: return 16ul << 20;
+            default: return 1;
+        }
+    }
+};
+
+/*
+ * Memory of the ColumnBuffers that exist, which is the working set of the benchmark: the cold cache state flushes it
+ * before every sample, see cache_control.h.
+ */
+class LiveBuffers {
+public:
+    typedef std::pair<const char *, size_t> Range;
+
+    static void add(const void *memory, size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex());
+        ranges().emplace_back(static_cast<const char *>(memory), bytes);
+    }
+
+    static void remove(const void *memory) {
+        std::lock_guard<std::mutex> lock(mutex());
+        auto &live = ranges();
+        live.erase(std::remove_if(live.begin(), live.end(), [&](const Range &range) {
+            return range.first == memory;
+        }), live.end());
+    }
+
+    static std::vector<Range> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex());
+        return ranges();
+    }
+
+private:
+    static std::mutex &mutex() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::vector<Range> &ranges() {
+        static std::vector<Range> live;
+        return live;
+    }
+};
+
+template <class T>
+class ColumnBuffer {
+public:
+    ColumnBuffer() = default;
+
+    explicit ColumnBuffer(size_t count, PageMode pages = PageMode::Default) : count(count) {
+        if (count == 0) return;
+        elements = static_cast<T *>(ColumnAllocator::allocate(count * sizeof(T), pages, mapping, mappedBytes));
+        LiveBuffers::add(elements, count * sizeof(T));
+    }
+
+    ColumnBuffer(ColumnBuffer &&other) noexcept { swap(other); }
+
+    ColumnBuffer &operator=(ColumnBuffer &&other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ColumnBuffer(const ColumnBuffer &) = delete;
+    ColumnBuffer &operator=(const ColumnBuffer &) = delete;
+
+    ~ColumnBuffer() {
+        if (!mapping) return;
+        LiveBuffers::remove(elements);
+        ColumnAllocator::deallocate(mapping, mappedBytes);
+    }
+
+    T *data() { return elements; }
+    const T *data() const { return elements; }
+    size_t size() const { return count; }
+    size_t sizeInBytes() const { return count * sizeof(T); }
+
+    T &operator[](size_t index) { return elements[index]; }
+    const T &operator[](size_t index) const { return elements[index]; }
+
+private:
+    void swap(ColumnBuffer &other) {
+        std::swap(elements, other.elements);
+        std::swap(count, other.count);
+        std::swap(mapping, other.mapping);
+        std::swap(mappedBytes, other.mappedBytes);
+    }
+
+    T *elements = nullptr;
+    size_t count = 0;
+    void *mapping = nullptr;
+    size_t mappedBytes = 0;
+};
+
+#endif // COLUMN_MEMORY_H
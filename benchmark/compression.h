@@ -0,0 +1,234 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "column_memory.h"
+#include "predicate.h"
+
+/*
+ * Dictionary-encoded columns with bit-packed codes of 1 to 32 bits.
+ *
+ * Horizontal packing stores the codes one after another, LSB first. Vertical packing follows SIMD-BP128: a block of
+ * 32 * lanes codes is spread over *lanes* 32 bit lanes, code i of a block goes to lane i % lanes, and word w of all
+ * lanes is stored contiguously, so a single vector load fetches word w of every lane. Scans evaluate the predicate on
+ * the packed codes, the values are never decompressed.
+ */
+
+enum class Packing { Horizontal, Vertical };
+
+inline bool parsePacking(const std::string &name, Packing &packing) {
+    if (name == "horizontal") packing = Packing::Horizontal;
+    else if (name == "vertical") packing = Packing::Vertical;
+    else return false;
+    return true;
+}
+
+inline std::string packingName(Packing packing) {
+    return packing == Packing::Horizontal ? "horizontal" : "vertical";
+}
+
+inline uint32_t codeMask(unsigned bitWidth) {
+    return bitWidth == 32 ? ~0u : (1u << bitWidth) - 1;
+}
+
+class PackedColumn {
+public:
+    // *lanes* is only used by the vertical layout and has to match the vector width of the scan kernel
+    PackedColumn(Packing packing, unsigned bitWidth, size_t rows, unsigned lanes, PageMode pages = PageMode::Default)
+            : packing(packing), bitWidth(bitWidth), rows(rows), lanes(lanes) {
+        // horizontal scans read 8 bytes at a time, so the last code needs 8 bytes of padding
+        size_t bits = packing == Packing::Horizontal ? rows * bitWidth + 64 : blockCount() * blockRows() * bitWidth;
+        words = ColumnBuffer<uint32_t>((bits + 31) / 32, pages);
+    }
+
+    size_t blockRows() const { return 32 * lanes; }
+    size_t blockCount() const { return (rows + blockRows() - 1) / blockRows(); }
+    size_t blockWords() const { return bitWidth * lanes; }
+
+    // Bytes of packed codes, without padding
+    size_t bytes() const { return (rows * bitWidth + 7) / 8; }
+
+    // First word and number of words that hold the codes of rows [begin, end)
+    std::pair<size_t, size_t> wordRange(size_t begin, size_t end) const {
+        if (packing == Packing::Horizontal) {
+            size_t first = begin * bitWidth / 32;
+            return {first, (end * bitWidth + 31) / 32 - first};
+        }
+        size_t first = begin / blockRows() * blockWords();
+        return {first, (end + blockRows() - 1) / blockRows() * blockWords() - first};
+    }
+
+    void set(size_t row, uint32_t code) {
+        if (packing == Packing::Horizontal) {
+            setBits(row * bitWidth, code);
+        } else {
+            size_t block = row / blockRows(), slot = (row % blockRows()) / lanes, lane = row % lanes;
+            size_t offset = slot * bitWidth;
+            // bit offset inside the interleaved word stream of this lane
+            size_t word = block * blockWords() + offset / 32 * lanes + lane;
+            uint64_t value = (uint64_t) code << (offset % 32);
+            words[word] |= (uint32_t) value;
+            if (offset % 32 + bitWidth > 32) words[word + lanes] |= (uint32_t) (value >> 32);
+        }
+    }
+
+    inline uint32_t horizontalCode(size_t row) const {
+        size_t bit = row * bitWidth;
+        uint64_t chunk;
+        memcpy(&chunk, reinterpret_cast<const uint8_t *>(words.data()) + bit / 8, sizeof(chunk));
+        return (uint32_t) (chunk >> (bit % 8)) & codeMask(bitWidth);
+    }
+
+    Packing packing;
+    unsigned bitWidth;
+    size_t rows;
+    unsigned lanes;
+    ColumnBuffer<uint32_t> words; // zero-filled
+
+private:
+    void setBits(size_t bit, uint32_t code) {
+        size_t word = bit / 32;
+        uint64_t value = (uint64_t) code << (bit % 32);
+        words[word] |= (uint32_t) value;
+        if (bit % 32 + bitWidth > 32) words[word + 1] |= (uint32_t) (value >> 32);
+    }
+};
+
+// Predicate on codes: the code range [low, high], or a list of codes for IN-lists that do not form a range
+class CodePredicate {
+public:
+    static CodePredicate range(uint32_t low, uint32_t high) {
+        CodePredicate predicate;
+        predicate.low = low;
+        predicate.high = high;
+        return predicate;
+    }
+
+    static CodePredicate list(std::vector<uint32_t> codes) {
+        std::sort(codes.begin(), codes.end());
+        codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+        // no code at all is the empty range, consecutive codes are a range as well
+        if (codes.empty()) return CodePredicate();
+        if (codes.back() - codes.front() == codes.size() - 1) return range(codes.front(), codes.back());
+        CodePredicate predicate;
+        predicate.codes = codes;
+        if (codes.size() > SIMD_IN_LIST_LIMIT) predicate.hashSet = std::make_shared<HashSet<uint32_t>>(codes);
+        return predicate;
+    }
+
+    bool isList() const { return !codes.empty(); }
+    bool usesLookup() const { return hashSet != nullptr; }
+
+    inline bool matches(uint32_t code) const {
+        if (codes.empty()) return code >= low && code <= high;
+        if (hashSet) return hashSet->contains(code);
+        bool found = false;
+        for (auto candidate: codes) found |= candidate == code;
+        return found;
+    }
+
+    // Number of codes below 2^bitWidth that satisfy the predicate
+    uint64_t matchingCodes(unsigned bitWidth) const {
+        if (!codes.empty()) return std::upper_bound(codes.begin(), codes.end(), codeMask(bitWidth)) - codes.begin();
+        if (low > high || low > codeMask(bitWidth)) return 0;
+        return (uint64_t) std::min(high, codeMask(bitWidth)) - low + 1;
+    }
+
+    // Draws a code that satisfies the predicate
+    template <class Generator>
+    uint32_t matchingCode(Generator &generator) const {
+        if (!codes.empty()) return codes[std::uniform_int_distribution<size_t>(0, codes.size() - 1)(generator)];
+        return std::uniform_int_distribution<uint32_t>(low, high)(generator);
+    }
+
+    // Draws a code below 2^bitWidth that does not satisfy the predicate, there has to be one
+    template <class Generator>
+    uint32_t nonMatchingCode(Generator &generator, unsigned bitWidth) const {
+        std::uniform_int_distribution<uint32_t> any(0, codeMask(bitWidth));
+        uint32_t code;
+        do {
+            code = any(generator);
+        } while (matches(code));
+        return code;
+    }
+
+    uint32_t low = 1;
+    uint32_t high = 0;
+    std::vector<uint32_t> codes;
+
+private:
+    std::shared_ptr<HashSet<uint32_t>> hashSet;
+};
+
+/*
+ * Order preserving dictionary, code i stands for the i-th smallest value. Besides a sorted list of distinct values it
+ * can describe a dense domain first, first + 1, ..., which is never materialized, so that 32 bit codes stay cheap.
+ */
+template <class T>
+class Dictionary {
+public:
+    explicit Dictionary(std::vector<T> values) : values(values), first(0), domainSize(0) {
+        std::sort(this->values.begin(), this->values.end());
+        this->values.erase(std::unique(this->values.begin(), this->values.end()), this->values.end());
+    }
+
+    static Dictionary dense(T first, uint64_t size) {
+        Dictionary dictionary{std::vector<T>()};
+        dictionary.first = first;
+        dictionary.domainSize = size;
+        return dictionary;
+    }
+
+    uint64_t size() const { return values.empty() ? domainSize : values.size(); }
+
+    T value(uint64_t code) const { return values.empty() ? (T) (first + code) : values[code]; }
+
+    // Looks up the code of *value*, returns false if the value is not in the dictionary
+    bool encode(T value, uint32_t &code) const {
+        code = (uint32_t) lowerBound(value);
+        return code < size() && this->value(code) == value;
+    }
+
+    // Translates a predicate on values into one on codes, which works because the dictionary is sorted
+    CodePredicate translate(const Predicate<T> &predicate) const {
+        if (predicate.type() == PredicateType::InList) {
+            std::vector<uint32_t> codes;
+            uint32_t code;
+            for (auto value: predicate.values) {
+                if (encode(value, code)) codes.push_back(code);
+            }
+            return CodePredicate::list(codes);
+        }
+        uint64_t low = lowerBound(predicate.low), high = upperBound(predicate.high);
+        if (low >= high) return CodePredicate();
+        return CodePredicate::range((uint32_t) low, (uint32_t) (high - 1));
+    }
+
+private:
+    // Index of the first value >= value
+    uint64_t lowerBound(T value) const {
+        if (!values.empty()) return std::lower_bound(values.begin(), values.end(), value) - values.begin();
+        return value <= first ? 0 : std::min<uint64_t>(domainSize, (uint64_t) value - (uint64_t) first);
+    }
+
+    // Index of the first value > value
+    uint64_t upperBound(T value) const {
+        if (!values.empty()) return std::upper_bound(values.begin(), values.end(), value) - values.begin();
+        return value < first ? 0 : std::min<uint64_t>(domainSize, (uint64_t) value - (uint64_t) first + 1);
+    }
+
+    std::vector<T> values;
+    T first;
+    uint64_t domainSize;
+};
+
+#endif // COMPRESSION_H
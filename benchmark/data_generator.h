@@ -0,0 +1,257 @@
+#ifndef DATA_GENERATOR_H
+#define DATA_GENERATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+
+/*
+ * Building blocks of the data generator.
+ *
+ * Every random decision about a row is drawn from a generator keyed by (seed, stream, row), so a row gets the same
+ * value whichever thread writes it and whatever was generated before. That lets every worker fill its own partition,
+ * and the data only depends on --seed and the generator options.
+ */
+
+enum class Distribution { Uniform, Zipf, Sorted, Runs, LowCardinality };
+
+inline bool parseDistribution(const std::string &name, Distribution &distribution) {
+    if (name == "uniform") distribution = Distribution::Uniform;
+    else if (name == "zipf") distribution = Distribution::Zipf;
+    else if (name == "sorted") distribution = Distribution::Sorted;
+    else if (name == "runs") distribution = Distribution::Runs;
+    else if (name == "lowcard") distribution = Distribution::LowCardinality;
+    else return false;
+    return true;
+}
+
+inline std::string distributionName(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::Uniform: return "uniform";
+        case Distribution::Zipf: return "zipf";
+        case Distribution::Sorted: return "sorted";
+        case Distribution::Runs: return "runs";
+        case Distribution::LowCardinality: return "lowcard";
+    }
+    return "unknown";
+}
+
+struct GeneratorOptions {
+    Distribution distribution;
+    uint64_t seed;
+    double zipfExponent;
+    uint64_t runLength;
+    uint64_t cardinality; // 0: the whole domain (16 values for lowcard)
+};
+
+// Finalizer of SplitMix64, a bijection that spreads every input bit over the whole word
+inline uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ull;
+
+// Counter-based generator: the i-th number of (seed, stream, key) is a hash of these four, usable with <random>
+class CounterRng {
+public:
+    typedef uint64_t result_type;
+
+    CounterRng(uint64_t seed, uint64_t stream, uint64_t key)
+            : key(mix64(mix64(seed + stream * GOLDEN_GAMMA) + key)) {}
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+
+    uint64_t operator()() { return mix64(key + ++counter * GOLDEN_GAMMA); }
+
+private:
+    uint64_t key;
+    uint64_t counter = 0;
+};
+
+/*
+ * Pseudo-random permutation of [0, size): a balanced Feistel network on the smallest even number of bits that covers
+ * size, with cycle walking for the values outside. The domain is less than 4 * size, so a lookup takes fewer than four
+ * trips through the network on average.
+ */
+class FeistelPermutation {
+public:
+    FeistelPermutation(uint64_t size, uint64_t seed, uint64_t stream) : size(size) {
+        while (halfBits < 32 && (1ull << (2 * halfBits)) < size) halfBits++;
+        halfMask = (1ull << halfBits) - 1;
+        CounterRng keys(seed, stream, 0);
+        for (auto &roundKey: roundKeys) roundKey = keys();
+    }
+
+    uint64_t operator()(uint64_t index) const {
+        do {
+            index = encrypt(index);
+        } while (index >= size);
+        return index;
+    }
+
+private:
+    uint64_t encrypt(uint64_t value) const {
+        uint64_t left = value >> halfBits, right = value & halfMask;
+        for (auto roundKey: roundKeys) {
+            uint64_t next = left ^ (mix64(right ^ roundKey) & halfMask);
+            left = right;
+            right = next;
+        }
+        return (left << halfBits) | right;
+    }
+
+    uint64_t size;
+    unsigned halfBits = 1;
+    uint64_t halfMask;
+    uint64_t roundKeys[4];
+};
+
+/*
+ * Zipf distribution on the ranks 1..n, P(k) ~ k^-exponent, sampled in constant time by rejection-inversion
+ * (Hörmann and Derflinger, "Rejection-inversion to generate variates from monotone discrete distributions", 1996).
+ */
+class ZipfDistribution {
+public:
+    ZipfDistribution(uint64_t n, double exponent) : n(n), exponent(exponent) {
+        hIntegralX1 = hIntegral(1.5) - 1;
+        hIntegralN = hIntegral(n + 0.5);
+        s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    template <class Generator>
+    uint64_t operator()(Generator &generator) const {
+        std::uniform_real_distribution<double> unit(0, 1);
+        while (true) {
+            double u = hIntegralN + unit(generator) * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            uint64_t k = std::min(n, (uint64_t) std::max(1.0, x + 0.5));
+            if (k - x <= s || u >= hIntegral(k + 0.5) - h(k)) return k;
+        }
+    }
+
+private:
+    double h(double x) const { return std::exp(-exponent * std::log(x)); }
+
+    double hIntegral(double x) const {
+        double logX = std::log(x);
+        return helper2((1 - exponent) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = std::max(-1.0, x * (1 - exponent));
+        return std::exp(helper1(t) * x);
+    }
+
+    // log(1 + x) / x and (exp(x) - 1) / x, without the cancellation around 0
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+    }
+
+    uint64_t n;
+    double exponent;
+    double hIntegralX1, hIntegralN, s;
+};
+
+// Streams of the generators, a column c uses VALUE_STREAM + c
+enum : uint64_t {
+    SELECTION_STREAM = 1, COLUMN_MATCH_STREAM = 2, CHAIN_STREAM = 3, JOIN_KEY_STREAM = 4, POSITION_STREAM = 5,
+    WRITER_STREAM = 6, LOOKUP_STREAM = 7, VALUE_STREAM = 16
+};
+
+/*
+ * Picks the qualifying rows of a column with an exact number of them. Sorted data qualifies at the start, runs qualify
+ * or not as a whole (apart from a partial last run), all other distributions spread the qualifying rows uniformly.
+ */
+class RowSelection {
+public:
+    RowSelection(uint64_t rows, double selectivity, const GeneratorOptions &options)
+            : qualifying(std::llround(selectivity * rows)), sorted(options.distribution == Distribution::Sorted),
+              runLength(options.distribution == Distribution::Runs ? std::max<uint64_t>(1, options.runLength) : 1),
+              fullRows(rows / runLength * runLength),
+              permutation(std::max<uint64_t>(1, rows / runLength), options.seed, SELECTION_STREAM) {}
+
+    bool qualifies(uint64_t row) const {
+        if (sorted) return row < qualifying;
+        // the rows of a permuted run stay together, the rows after the last full run keep their position
+        uint64_t position = row < fullRows ? permutation(row / runLength) * runLength + row % runLength : row;
+        return position < qualifying;
+    }
+
+private:
+    uint64_t qualifying;
+    bool sorted;
+    uint64_t runLength;
+    uint64_t fullRows;
+    FeistelPermutation permutation;
+};
+
+/*
+ * Draws indexes into a domain of *domainSize* values following the distribution. Index 0 is the most frequent one
+ * under Zipf, sorted indexes ascend over the rows and every row of a run gets the same index.
+ */
+class IndexGenerator {
+public:
+    IndexGenerator(const GeneratorOptions &options, uint64_t rows, uint64_t domainSize)
+            : options(options), rows(std::max<uint64_t>(1, rows)),
+              cardinality(indexCardinality(options, domainSize)), zipf(cardinality, options.zipfExponent) {}
+
+    // Values of one row and column are drawn from this generator, one after another
+    CounterRng generator(uint64_t row, uint64_t column) const {
+        uint64_t runLength = options.distribution == Distribution::Runs ? std::max<uint64_t>(1, options.runLength) : 1;
+        return CounterRng(options.seed, VALUE_STREAM + column, row / runLength);
+    }
+
+    uint64_t index(uint64_t row, CounterRng &generator) const {
+        switch (options.distribution) {
+            case Distribution::Zipf:
+                return zipf(generator) - 1;
+            case Distribution::Sorted:
+                return (uint64_t) ((unsigned __int128) row * cardinality / rows);
+            default:
+                return std::uniform_int_distribution<uint64_t>(0, cardinality - 1)(generator);
+        }
+    }
+
+    uint64_t size() const { return cardinality; }
+
+private:
+    static uint64_t indexCardinality(const GeneratorOptions &options, uint64_t domainSize) {
+        uint64_t cardinality = options.cardinality;
+        if (options.distribution == Distribution::Uniform || cardinality == 0) {
+            cardinality = options.distribution == Distribution::LowCardinality ? 16 : domainSize;
+        }
+        return std::max<uint64_t>(1, std::min(cardinality, domainSize));
+    }
+
+    GeneratorOptions options;
+    uint64_t rows;
+    uint64_t cardinality;
+    ZipfDistribution zipf;
+};
+
+// Value of an index of a domain of *cardinality* values of T: 0, 1, ... if T has that many positive values, otherwise
+// the domain starts at T's minimum
+template <class T>
+T domainValue(uint64_t index, uint64_t cardinality) {
+    if (cardinality - 1 <= (uint64_t) std::numeric_limits<T>::max()) return (T) index;
+    return (T) ((uint64_t) (int64_t) std::numeric_limits<T>::min() + index);
+}
+
+// Number of values of T, saturated for 64 bit types
+template <class T>
+uint64_t domainSize() {
+    return sizeof(T) >= 8 ? std::numeric_limits<uint64_t>::max() : 1ull << (8 * sizeof(T));
+}
+
+#endif // DATA_GENERATOR_H
@@ -126,7 +126,9 @@ inline void Flags::Var(T &var, char shortFlag, std::string longFlag, T defaultVa
     struct option op;
     this->entry(op, shortFlag, longFlag, defaultValue, description, descriptionGroup);
 
-    this->optionStr += ":";
+    if (shortFlag) {
+        this->optionStr += ":";
+    }
 
     op.has_arg = required_argument;
     var = defaultValue;
@@ -0,0 +1,213 @@
+#ifndef HASH_JOIN_H
+#define HASH_JOIN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "column_memory.h"
+#include "data_generator.h"
+
+/*
+ * Equi-joins of an inner relation R, which the hash tables are built on, and an outer relation S that probes them.
+ * Both are arrays of (key, payload) tuples. Key 0 marks an empty slot, so the generated keys never take it.
+ *
+ *   npo    no partitioning: all threads build one shared linear probing table with compare-and-swap, then probe it.
+ *          Once R outgrows the caches every build and probe is a cache (and often TLB) miss.
+ *   radix  both relations are radix-partitioned on the hash in one or two passes, until a partition of R fits in the
+ *          cache, then every pair of partitions is joined with a small bucket-chained table (Manegold et al., Kim et
+ *          al., Balkesen et al.). The partitions are written through software write-combining buffers: a cache line
+ *          per partition collects the tuples and is copied out once it is full, so the fan-out is not limited by the
+ *          TLB and the output sees whole lines.
+ */
+
+enum class JoinAlgorithm { NoPartitioning, Radix };
+
+struct JoinOptions {
+    unsigned radixBits; // 0: enough for partitions of R of RADIX_PARTITION_BYTES
+    int passes; // of the radix join, 1 or 2
+    double outerRatio; // rows of S per row of R
+};
+
+inline bool parseJoinAlgorithm(const std::string &name, JoinAlgorithm &algorithm) {
+    if (name == "npo") algorithm = JoinAlgorithm::NoPartitioning;
+    else if (name == "radix") algorithm = JoinAlgorithm::Radix;
+    else return false;
+    return true;
+}
+
+inline std::string joinAlgorithmName(JoinAlgorithm algorithm) {
+    return algorithm == JoinAlgorithm::NoPartitioning ? "npo" : "radix";
+}
+
+template <class T>
+struct Tuple {
+    T key;
+    T payload;
+};
+
+// Multiplicative hashing, the partitions and buckets are taken from the top bits
+inline uint64_t hashKey(int64_t key) {
+    return (uint64_t) key * GOLDEN_GAMMA;
+}
+
+// *bits* bits of the hash, after skipping its *skip* top bits
+inline size_t hashBits(int64_t key, unsigned skip, unsigned bits) {
+    return bits == 0 ? 0 : (size_t) ((hashKey(key) << skip) >> (64 - bits));
+}
+
+inline unsigned log2Ceil(size_t value) {
+    unsigned bits = 0;
+    while (((size_t) 1 << bits) < value) bits++;
+    return bits;
+}
+
+/* No partitioning */
+
+// Linear probing table of at least twice as many slots as tuples, shared by all threads
+template <class T>
+class SharedHashTable {
+public:
+    SharedHashTable(size_t tuples, PageMode pages)
+            : bits(log2Ceil(std::max<size_t>(16, 2 * tuples))), mask(((size_t) 1 << bits) - 1),
+              slots((size_t) 1 << bits, pages) {}
+
+    Tuple<T> *data() { return slots.data(); }
+    size_t size() const { return slots.size(); }
+
+    // Empties slots [begin, end)
+    void clear(size_t begin, size_t end) { memset(slots.data() + begin, 0, (end - begin) * sizeof(Tuple<T>)); }
+
+    // Claims an empty slot with compare-and-swap on the key, the payload is only read after the build
+    inline void insert(const Tuple<T> &tuple) {
+        size_t slot = hashBits(tuple.key, 0, bits);
+        while (true) {
+            T expected = 0;
+            if (__atomic_load_n(&slots[slot].key, __ATOMIC_RELAXED) == 0 &&
+                __atomic_compare_exchange_n(&slots[slot].key, &expected, tuple.key, false, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                slots[slot].payload = tuple.payload;
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    // Slot a probe for *key* starts at and the slot after *slot*, for probes that are interleaved, see lookups.h
+    inline size_t home(T key) const { return hashBits(key, 0, bits); }
+    inline size_t next(size_t slot) const { return (slot + 1) & mask; }
+    inline const Tuple<T> &at(size_t slot) const { return slots[slot]; }
+
+    // Number of tuples with the key, their payloads are added to *checksum*
+    inline uint64_t probe(T key, uint64_t &checksum) const {
+        uint64_t matches = 0;
+        for (size_t slot = hashBits(key, 0, bits); slots[slot].key != 0; slot = (slot + 1) & mask) {
+            if (slots[slot].key == key) {
+                matches++;
+                checksum += slots[slot].payload;
+            }
+        }
+        return matches;
+    }
+
+private:
+    unsigned bits;
+    size_t mask;
+    ColumnBuffer<Tuple<T>> slots;
+};
+
+/* Radix partitioning */
+
+// Software write-combining buffer of one partition
+template <class T>
+struct alignas(CACHE_LINE_BYTES) CombiningLine {
+    static const size_t TUPLES = CACHE_LINE_BYTES / sizeof(Tuple<T>);
+    Tuple<T> tuples[TUPLES];
+};
+
+// Adds the tuples of every partition of *tuples* to *histogram*, which has 2^bits entries
+template <class T>
+void radixHistogram(const Tuple<T> *tuples, size_t count, unsigned skip, unsigned bits, size_t *histogram) {
+    for (size_t i = 0; i < count; i++) histogram[hashBits(tuples[i].key, skip, bits)]++;
+}
+
+/*
+ * Scatters *tuples* into the partitions of *out*, partition p goes to out[offsets[p]] onwards. The lines of *lines*
+ * collect the tuples of a partition and are written out once the line of the output they belong to is complete, the
+ * first and last line of a partition may be shared with another thread and are only written partially. *out* has to
+ * start on a cache line.
+ */
+template <class T>
+void radixPartition(const Tuple<T> *tuples, size_t count, unsigned skip, unsigned bits, const size_t *offsets,
+                    Tuple<T> *out, CombiningLine<T> *lines, size_t *positions) {
+    const size_t lineTuples = CombiningLine<T>::TUPLES, fanout = (size_t) 1 << bits;
+    std::copy(offsets, offsets + fanout, positions);
+    for (size_t i = 0; i < count; i++) {
+        size_t p = hashBits(tuples[i].key, skip, bits);
+        size_t position = positions[p]++;
+        lines[p].tuples[position % lineTuples] = tuples[i];
+        if ((position + 1) % lineTuples == 0) {
+            size_t lineStart = position + 1 - lineTuples;
+            size_t from = std::max(lineStart, offsets[p]);
+            memcpy(out + from, lines[p].tuples + (from - lineStart), (position + 1 - from) * sizeof(Tuple<T>));
+        }
+    }
+    for (size_t p = 0; p < fanout; p++) {
+        size_t from = std::max(positions[p] - positions[p] % lineTuples, offsets[p]);
+        if (from < positions[p]) {
+            memcpy(out + from, lines[p].tuples + from % lineTuples, (positions[p] - from) * sizeof(Tuple<T>));
+        }
+    }
+}
+
+/*
+ * Bucket-chained table of one partition of R: buckets[h] is one past the index of the last tuple of bucket h, next[i]
+ * the same for the tuple before tuple i. The buckets take the hash bits after the *skip* radix bits.
+ */
+class BucketChains {
+public:
+    template <class T>
+    void build(const Tuple<T> *inner, size_t count, unsigned skip) {
+        this->skip = skip;
+        bits = std::max(1u, log2Ceil(count));
+        buckets.assign((size_t) 1 << bits, 0);
+        if (next.size() < count) next.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            size_t bucket = hashBits(inner[i].key, skip, bits);
+            next[i] = buckets[bucket];
+            buckets[bucket] = (uint32_t) (i + 1);
+        }
+    }
+
+    template <class T>
+    uint64_t probe(const Tuple<T> *inner, const Tuple<T> *outer, size_t count, uint64_t &checksum) const {
+        uint64_t matches = 0;
+        for (size_t i = 0; i < count; i++) {
+            T key = outer[i].key;
+            for (uint32_t r = buckets[hashBits(key, skip, bits)]; r != 0; r = next[r - 1]) {
+                if (inner[r - 1].key == key) {
+                    matches++;
+                    checksum += inner[r - 1].payload;
+                }
+            }
+        }
+        return matches;
+    }
+
+private:
+    unsigned skip = 0;
+    unsigned bits = 1;
+    std::vector<uint32_t> buckets;
+    std::vector<uint32_t> next;
+};
+
+// Bytes of R a partition should have at most, so that it and its table stay in the L2 cache
+static const size_t RADIX_PARTITION_BYTES = 64 * 1024;
+
+// Largest number of radix bits of all passes together, they are split evenly between the passes
+static const unsigned MAX_RADIX_BITS = 18;
+
+#endif // HASH_JOIN_H
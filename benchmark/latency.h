@@ -0,0 +1,79 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "column_memory.h"
+#include "data_generator.h"
+
+/*
+ * Dependent loads for the latency benchmark.
+ *
+ * The working set is an array of cache lines, each holding the address of the next one. The order is a random cycle
+ * through all lines, so every load has to wait for the one before it and neither the prefetchers nor the out-of-order
+ * engine can run ahead. Several chains follow disjoint parts of the cycle at once, which shows how many misses the
+ * core keeps in flight.
+ */
+
+static const int MAX_CHAINS = 16;
+
+struct alignas(CACHE_LINE_BYTES) ChainNode {
+    const ChainNode *next;
+};
+
+/*
+ * Links *count* nodes into one random cycle and returns the nodes in cycle order, so chain c of k starts at
+ * order[c * count / k]. Sattolo's algorithm draws a permutation that is a single cycle, node i links to node next[i].
+ * The cycle only depends on *seed* and *count*.
+ */
+inline std::vector<uint32_t> linkCycle(ChainNode *nodes, size_t count, uint64_t seed) {
+    std::vector<uint32_t> next(count);
+    for (size_t i = 0; i < count; i++) next[i] = (uint32_t) i;
+    CounterRng generator(seed, CHAIN_STREAM, count);
+    for (size_t i = count - 1; i > 0; i--) {
+        std::swap(next[i], next[std::uniform_int_distribution<size_t>(0, i - 1)(generator)]);
+    }
+    std::vector<uint32_t> order(count);
+    order[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        nodes[i].next = &nodes[next[i]];
+        if (i + 1 < count) order[i + 1] = next[order[i]];
+    }
+    return order;
+}
+
+// Follows *Chains* chains for *steps* nodes each, the chains are kept in registers
+template <int Chains>
+uint64_t chase(const ChainNode *const *starts, size_t steps) {
+    const ChainNode *nodes[Chains];
+    for (int c = 0; c < Chains; c++) nodes[c] = starts[c];
+    for (size_t s = 0; s < steps; s++) {
+        for (int c = 0; c < Chains; c++) nodes[c] = nodes[c]->next;
+    }
+    uint64_t sum = 0;
+    for (int c = 0; c < Chains; c++) sum += reinterpret_cast<uintptr_t>(nodes[c]);
+    return sum;
+}
+
+template <int Chains>
+struct ChaseTable {
+    static uint64_t run(int chains, const ChainNode *const *starts, size_t steps) {
+        return chains == Chains ? chase<Chains>(starts, steps) : ChaseTable<Chains - 1>::run(chains, starts, steps);
+    }
+};
+
+template <>
+struct ChaseTable<1> {
+    static uint64_t run(int, const ChainNode *const *starts, size_t steps) { return chase<1>(starts, steps); }
+};
+
+// 1 to MAX_CHAINS chains
+inline uint64_t chaseChains(int chains, const ChainNode *const *starts, size_t steps) {
+    return ChaseTable<MAX_CHAINS>::run(chains, starts, steps);
+}
+
+#endif // LATENCY_H
@@ -0,0 +1,334 @@
+#ifndef LOOKUPS_H
+#define LOOKUPS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <new>
+#include <string>
+
+#include "hash_join.h"
+#include "software_prefetch.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define HAVE_LOOKUP_COROUTINES
+#endif
+
+/*
+ * Batches of independent point lookups into an index, each a chain of dependent loads.
+ *
+ *   binary  binary search for a key in a sorted column, one load per halving of the range
+ *   hash    probe of a linear probing table (SharedHashTable) for a key, one load per slot visited
+ *
+ * Every key is in the index. The lookups of a batch are interleaved, so that the misses of several of them overlap:
+ *
+ *   naive  one lookup after another, only the out-of-order engine overlaps them
+ *   group  group prefetching: a group of *width* lookups advances one load at a time, and every lookup prefetches
+ *          its next load before the group moves on (Chen et al.)
+ *   amac   asynchronous memory access chaining: *width* lookups are in flight as state machines, and one that
+ *          finishes is replaced by the next lookup right away, so no lookup waits for the slowest of a group
+ *          (Kocberber et al.)
+ *   coro   the same as amac, with every lookup a C++20 coroutine that prefetches its next load and suspends
+ *          (Psaropoulos et al.). Needs a compiler with coroutines, see HAVE_LOOKUP_COROUTINES.
+ *
+ * An index tells a lookup where its next load goes and takes one step of it, so all interleavings run the same
+ * lookup code.
+ */
+
+enum class LookupIndex { Binary, Hash };
+
+inline bool parseLookupIndex(const std::string &name, LookupIndex &index) {
+    if (name == "binary") index = LookupIndex::Binary;
+    else if (name == "hash") index = LookupIndex::Hash;
+    else return false;
+    return true;
+}
+
+inline std::string lookupIndexName(LookupIndex index) {
+    return index == LookupIndex::Binary ? "binary" : "hash";
+}
+
+enum class Interleaving { Naive, Group, Amac, Coroutine };
+
+inline bool parseInterleaving(const std::string &name, Interleaving &interleaving) {
+    if (name == "naive") interleaving = Interleaving::Naive;
+    else if (name == "group") interleaving = Interleaving::Group;
+    else if (name == "amac") interleaving = Interleaving::Amac;
+    else if (name == "coro") interleaving = Interleaving::Coroutine;
+    else return false;
+    return true;
+}
+
+inline std::string interleavingName(Interleaving interleaving) {
+    switch (interleaving) {
+        case Interleaving::Naive: return "naive";
+        case Interleaving::Group: return "group";
+        case Interleaving::Amac: return "amac";
+        case Interleaving::Coroutine: return "coro";
+    }
+    return "unknown";
+}
+
+static const int MAX_INTERLEAVE = 64;
+
+// The value of row *row* of the sorted column and the key of tuple *row* of the hash table, never 0
+template <class T>
+inline T lookupKey(size_t row) {
+    return (T) (2 * row + 1);
+}
+
+// Rows of an index at most, so that the key of every row fits in T
+template <class T>
+inline size_t maxLookupRows() {
+    return (size_t) (((uint64_t) std::numeric_limits<T>::max() - 1) / 2 + 1);
+}
+
+// Binary search in a sorted column, the position of the key is found once the range has one row left
+template <class T>
+class BinaryIndex {
+public:
+    struct State {
+        T key;
+        const T *base; // first row of the range that holds the key
+        size_t count; // rows of the range
+    };
+
+    BinaryIndex(const T *column, size_t rows) : column(column), rows(rows) {}
+
+    inline void start(State &state, T key) const { state = {key, column, rows}; }
+
+    inline const void *address(const State &state) const { return state.base + state.count / 2; }
+
+    // Takes one step of the lookup in *state*, true when it is done. Found keys count in *matches*.
+    inline bool step(State &state, uint64_t &matches) const {
+        if (state.count > 1) {
+            size_t half = state.count / 2;
+            state.base = state.base[half] <= state.key ? state.base + half : state.base;
+            state.count -= half;
+            return false;
+        }
+        matches += *state.base == state.key;
+        return true;
+    }
+
+private:
+    const T *column;
+    size_t rows;
+};
+
+// Probes of a linear probing table, the keys are unique
+template <class T>
+class HashIndex {
+public:
+    struct State {
+        T key;
+        size_t slot;
+    };
+
+    explicit HashIndex(const SharedHashTable<T> &table) : table(table) {}
+
+    inline void start(State &state, T key) const { state = {key, table.home(key)}; }
+
+    inline const void *address(const State &state) const { return &table.at(state.slot); }
+
+    inline bool step(State &state, uint64_t &matches) const {
+        auto key = table.at(state.slot).key;
+        if (key == state.key || key == 0) {
+            matches += key != 0;
+            return true;
+        }
+        state.slot = table.next(state.slot);
+        return false;
+    }
+
+private:
+    const SharedHashTable<T> &table;
+};
+
+// Looks up keys[begin, end) one at a time, returns the number found
+template <class Index, class T>
+uint64_t lookupNaive(const Index &index, const T *keys, size_t begin, size_t end) {
+    uint64_t matches = 0;
+    typename Index::State state;
+    for (size_t i = begin; i < end; i++) {
+        index.start(state, keys[i]);
+        while (!index.step(state, matches)) {}
+    }
+    return matches;
+}
+
+template <class Index, class T>
+uint64_t lookupGroups(const Index &index, const T *keys, size_t begin, size_t end, int width) {
+    uint64_t matches = 0;
+    typename Index::State states[MAX_INTERLEAVE];
+    bool done[MAX_INTERLEAVE];
+    for (size_t i = begin; i < end; i += width) {
+        int group = (int) std::min<size_t>(width, end - i);
+        for (int g = 0; g < group; g++) {
+            index.start(states[g], keys[i + g]);
+            prefetchLine(index.address(states[g]));
+            done[g] = false;
+        }
+        for (int left = group; left > 0;) {
+            for (int g = 0; g < group; g++) {
+                if (done[g]) continue;
+                if (index.step(states[g], matches)) {
+                    done[g] = true;
+                    left--;
+                } else {
+                    prefetchLine(index.address(states[g]));
+                }
+            }
+        }
+    }
+    return matches;
+}
+
+template <class Index, class T>
+uint64_t lookupAmac(const Index &index, const T *keys, size_t begin, size_t end, int width) {
+    uint64_t matches = 0;
+    typename Index::State states[MAX_INTERLEAVE];
+    bool active[MAX_INTERLEAVE];
+    size_t next = begin;
+    int running = 0;
+    for (int w = 0; w < width; w++) {
+        active[w] = next < end;
+        if (!active[w]) continue;
+        index.start(states[w], keys[next++]);
+        prefetchLine(index.address(states[w]));
+        running++;
+    }
+    while (running > 0) {
+        for (int w = 0; w < width; w++) {
+            if (!active[w]) continue;
+            if (!index.step(states[w], matches)) {
+                prefetchLine(index.address(states[w]));
+            } else if (next < end) {
+                index.start(states[w], keys[next++]);
+                prefetchLine(index.address(states[w]));
+            } else {
+                active[w] = false;
+                running--;
+            }
+        }
+    }
+    return matches;
+}
+
+#ifdef HAVE_LOOKUP_COROUTINES
+
+/*
+ * Frames of the lookup coroutines of a thread, reused so that a lookup does not go through malloc. A thread keeps at
+ * most the frames of its widest interleaving, they are not freed.
+ */
+class FramePool {
+public:
+    static void *allocate(size_t bytes) {
+        if (bytes > FRAME_BYTES) return ::operator new(bytes);
+        if (!frames) return ::operator new(FRAME_BYTES);
+        auto frame = frames;
+        frames = frame->next;
+        return frame;
+    }
+
+    static void release(void *frame, size_t bytes) {
+        if (bytes > FRAME_BYTES) {
+            ::operator delete(frame);
+            return;
+        }
+        auto unused = static_cast<Frame *>(frame);
+        unused->next = frames;
+        frames = unused;
+    }
+
+private:
+    struct Frame {
+        Frame *next;
+    };
+
+    static const size_t FRAME_BYTES = 256;
+    // a plain pointer, so the thread-local needs no guard on every access
+    static inline thread_local Frame *frames = nullptr;
+};
+
+// A lookup that suspends before every load, it starts suspended
+struct LookupTask {
+    struct promise_type {
+        LookupTask get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void *operator new(size_t bytes) { return FramePool::allocate(bytes); }
+        static void operator delete(void *frame, size_t bytes) { FramePool::release(frame, bytes); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <class Index, class T>
+LookupTask lookupCoroutine(const Index &index, T key, uint64_t &matches) {
+    typename Index::State state;
+    index.start(state, key);
+    do {
+        prefetchLine(index.address(state));
+        co_await std::suspend_always();
+    } while (!index.step(state, matches));
+}
+
+template <class Index, class T>
+uint64_t lookupCoroutines(const Index &index, const T *keys, size_t begin, size_t end, int width) {
+    uint64_t matches = 0;
+    std::coroutine_handle<> tasks[MAX_INTERLEAVE];
+    size_t next = begin;
+    int running = 0;
+    for (int w = 0; w < width; w++) {
+        tasks[w] = next < end ? lookupCoroutine(index, keys[next++], matches).handle : nullptr;
+        running += (bool) tasks[w];
+    }
+    while (running > 0) {
+        for (int w = 0; w < width; w++) {
+            if (!tasks[w]) continue;
+            tasks[w].resume();
+            if (!tasks[w].done()) continue;
+            tasks[w].destroy();
+            tasks[w] = next < end ? lookupCoroutine(index, keys[next++], matches).handle : nullptr;
+            running -= !tasks[w];
+        }
+    }
+    return matches;
+}
+
+#endif // HAVE_LOOKUP_COROUTINES
+
+inline bool interleavingSupported(Interleaving interleaving) {
+#ifdef HAVE_LOOKUP_COROUTINES
+    (void) interleaving;
+    return true;
+#else
+    return interleaving != Interleaving::Coroutine;
+#endif
+}
+
+// Looks up keys[begin, end) with *width* lookups in flight (1 to MAX_INTERLEAVE), returns the number found
+template <class Index, class T>
+uint64_t lookupKeys(Interleaving interleaving, const Index &index, const T *keys, size_t begin, size_t end,
+                    int width) {
+    switch (interleaving) {
+        case Interleaving::Naive: return lookupNaive(index, keys, begin, end);
+        case Interleaving::Group: return lookupGroups(index, keys, begin, end, width);
+        case Interleaving::Amac: return lookupAmac(index, keys, begin, end, width);
+#ifdef HAVE_LOOKUP_COROUTINES
+        case Interleaving::Coroutine: return lookupCoroutines(index, keys, begin, end, width);
+#endif
+        default: return 0;
+    }
+}
+
+#endif // LOOKUPS_H
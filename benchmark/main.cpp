@@ -4,38 +4,39 @@
 #include <vector>
 #include <numeric>
 #include <chrono>
-#include <thread>
 #include <algorithm>
 #include <random>
+#include <cmath>
+#include <memory>
+#include <cstring>
+#include <atomic>
+#include <functional>
+#include <sstream>
 #include "flags.h"
+#include "aggregates.h"
+#include "cache_control.h"
+#include "column_file.h"
+#include "column_memory.h"
+#include "data_generator.h"
+#include "hash_join.h"
+#include "latency.h"
+#include "lookups.h"
+#include "morsel_scheduler.h"
+#include "numa_placement.h"
+#include "perf_counters.h"
+#include "prefetcher_control.h"
+#include "result_writer.h"
+#include "roofline.h"
+#include "sampling.h"
+#include "size_sweep.h"
+#include "table_layout.h"
+#include "scan_kernels.h"
+#include "software_prefetch.h"
+#include "worker_pool.h"
+#include "write_kernels.h"
 
 using namespace std;
 
-static const size_t KiB = 1024;
-static const size_t MiB = 1024 * KiB;
-static const size_t GiB = 1024 * MiB;
-#ifdef _ARCH_PPC64
-/* POWER8 */
-static const size_t DB_SIZES[] = {8 * KiB, 16 * KiB, 32 * KiB, 48 * KiB, 64 * KiB, 96 * KiB, 128 * KiB,
-                                    256 * KiB, 512 * KiB, 768 * KiB, /* L1 cache limit */
-                                    1 * MiB, 2 * MiB, 4 * MiB, 6 * MiB, /* L2 cache limit */
-                                    16 * MiB, 64 * MiB, 96 * MiB, /* L3 cache limit */
-                                    112 * MiB, 128 * MiB, /* L4 cache limit */
-                                    256 * MiB, 1 * GiB, 4 * GiB,
-                                    /*8 * GiB, 16 * GiB, 32 * GiB, 64 * GiB,
-                                    128 * GiB, 256 * GiB*/
-                                    };
-#else
-/* Intel E7-8890 v2 */
-static const size_t DB_SIZES[] = {8 * KiB, 16 * KiB, 32 * KiB, 48 * KiB, 64 * KiB, 96 * KiB, 128 * KiB,
-                                    256 * KiB, 384 * KiB, 480 * KiB, /* L1 cache limit*/
-                                    512 * KiB, 1 * MiB, 2* MiB, 3840 * KiB, /* L2 cache limit */
-                                    4 * MiB, 8 * MiB, 16 * MiB, 32 * MiB, 38400 * KiB, /* L3 cache limit */
-                                    64 * MiB, 128 * MiB, 256 * MiB, 1 * GiB, 4 * GiB};
-#endif
-
-static const float ITERATIONS_FACTOR = 1e4;
-
 vector<string> parseDataTypes(const string &dataTypes) {
     vector<string> result;
     stringstream ss(dataTypes);
@@ -47,138 +48,2074 @@ vector<string> parseDataTypes(const string &dataTypes) {
     return result;
 }
 
-void clearCache() {
-  vector<int8_t> clear;
+// Scan parameters that are the same for every size and data type of a run
+struct ScanOptions {
+    ScanKernel kernel;
+    BranchMode branchMode;
+    OutputMode outputMode;
+    PredicateType predicateType;
+    size_t inListSize;
+    int predicateColumns;
+    double selectivity; // < 0: plain 0- or random-initialization without a selectivity target
+    Packing packing; // only used for bit-packed columns
+    Placement placement;
+    int memoryNode; // for Placement::Node
+    PageMode pages;
+    GeneratorOptions generator;
+    Aggregate aggregate; // None: the scan counts or materializes the qualifying rows
+    bool filtered; // aggregate only the qualifying rows
+    size_t groups; // 0: no GROUP BY
+    size_t morselRows; // 0: every thread scans a static partition
+};
 
-  // maximum cache size for a node is:
-  // POWER8: 768 KiB L1 + 6 MiB L2 + 96 MiB L3 + up to 128MiB L4 (off-chip) = 230.75 MiB
-  // Intel E7-8890 v2: 480 KiB L1 + 3.75 MiB L2 + 37.5 MiB L3 = 41.71875 MiB
-  // --> 256MiB is enough to clear all cache levels
-  clear.resize(256 * MiB, 42);
+// e.g. "sum filtered by 16 groups"
+static string aggregateLabel(const ScanOptions &options) {
+    auto label = aggregateName(options.aggregate);
+    if (options.aggregate != Aggregate::None && options.filtered) label += " filtered";
+    if (options.groups > 0) label += " by " + to_string(options.groups) + " groups";
+    return label;
+}
 
-  for (auto entry: clear) {
-    entry++;
-  }
+// Column store columns start on a cache line, so they are padded to a multiple of it
+template <class T>
+static size_t columnStride(size_t colLength) {
+    return alignUp(colLength * sizeof(T), CACHE_LINE_BYTES) / sizeof(T);
+}
 
-  clear.resize(0);
+static size_t elementIndex(size_t row, size_t column, size_t columnStride, int colCount) {
+    return colCount > 1 ? row * colCount + column : column * columnStride + row;
+}
+
+// Column store tables keep their columns one after another, row store tables interleave them
+template <class T>
+static size_t tableElements(size_t colLength, int colCount, const ScanOptions &options) {
+    return colCount > 1 ? colLength * colCount : columnStride<T>(colLength) * options.predicateColumns;
 }
 
+// Draws non-qualifying values from the distribution, redrawing the ones that satisfy the predicate
 template <class T>
-static vector<T> generateData(size_t size, bool randomInit)
+static T nonMatchingValue(const IndexGenerator &indexes, size_t row, CounterRng &generator,
+                          const Predicate<T> &predicate) {
+    for (int attempt = 0; attempt < 64; attempt++) {
+        T value = domainValue<T>(indexes.index(row, generator), indexes.size());
+        if (!predicate.matches(value)) return value;
+    }
+    // e.g. sorted data, where every draw of a row is the same
+    return predicate.nonMatchingValue(generator);
+}
+
+/*
+ * Writes rows [begin, end) of a table, every element of them. Without a selectivity target the values are zeros, or
+ * drawn from the distribution with -r or any distribution but uniform. With a target the predicate selects exactly
+ * round(selectivity * colLength) rows of the table, see RowSelection. With several predicate columns a
+ * non-qualifying row still satisfies the predicate on each column with probability selectivity^(1/k), but never on
+ * all of them.
+ */
+template <class T>
+static void generateRows(T *data, size_t colLength, int colCount, size_t begin, size_t end, bool randomInit,
+                         const ScanOptions &options, const Predicate<T> &predicate)
 {
-    if (randomInit) {
-        static uniform_int_distribution<T> distribution(numeric_limits<T>::min(), numeric_limits<T>::max());
-        static default_random_engine generator;
+    const auto &generatorOptions = options.generator;
+    const bool drawValues = randomInit || generatorOptions.distribution != Distribution::Uniform;
+    const bool targeted = options.selectivity >= 0;
+    const int predicateColumns = options.predicateColumns;
+    const int columns = colCount > 1 ? colCount : predicateColumns;
+    const double columnSelectivity = pow(max(0.0, options.selectivity), 1.0 / predicateColumns);
+    IndexGenerator indexes(generatorOptions, colLength, domainSize<T>());
+    RowSelection selection(colLength, max(0.0, options.selectivity), generatorOptions);
+    uniform_real_distribution<double> coin(0, 1);
+    vector<bool> columnMatches(predicateColumns);
 
-        vector<T> data(size);
-        generate(data.begin(), data.end(), []() { return distribution(generator); });
-        return data;
-    } else {
-        return vector<T>(size, 0);
+    for (size_t j = begin; j < end; j++) {
+        if (targeted && selection.qualifies(j)) {
+            fill(columnMatches.begin(), columnMatches.end(), true);
+        } else if (targeted) {
+            CounterRng generator(generatorOptions.seed, COLUMN_MATCH_STREAM, j);
+            bool all = true;
+            for (int c = 0; c < predicateColumns; c++) {
+                columnMatches[c] = predicateColumns > 1 && coin(generator) < columnSelectivity;
+                all &= columnMatches[c];
+            }
+            if (all) columnMatches[uniform_int_distribution<int>(0, predicateColumns - 1)(generator)] = false;
+        }
+        for (int c = 0; c < columns; c++) {
+            auto generator = indexes.generator(j, c);
+            T value = 0;
+            if (targeted && c < predicateColumns) {
+                value = columnMatches[c] ? predicate.matchingValue(generator)
+                                         : nonMatchingValue(indexes, j, generator, predicate);
+            } else if (drawValues) {
+                value = domainValue<T>(indexes.index(j, generator), indexes.size());
+            }
+            data[elementIndex(j, c, columnStride<T>(colLength), colCount)] = value;
+        }
     }
 }
 
-static volatile bool threadFlag = false;
+/*
+ * Writes the codes of rows [begin, end) of a dictionary-encoded column, the same way generateRows() writes values.
+ * 0-initialization stores the code of the value 0.
+ */
+static void generatePackedRows(PackedColumn &column, size_t begin, size_t end, bool randomInit,
+                               const ScanOptions &options, uint32_t zeroCode, const CodePredicate &predicate)
+{
+    const auto &generatorOptions = options.generator;
+    const bool drawCodes = randomInit || generatorOptions.distribution != Distribution::Uniform;
+    IndexGenerator indexes(generatorOptions, column.rows, (uint64_t) codeMask(column.bitWidth) + 1);
+    RowSelection selection(column.rows, max(0.0, options.selectivity), generatorOptions);
 
-static vector<long long int> threadTimes;
+    for (size_t j = begin; j < end; j++) {
+        auto generator = indexes.generator(j, 0);
+        uint32_t code = zeroCode;
+        if (options.selectivity >= 0 && selection.qualifies(j)) {
+            code = predicate.matchingCode(generator);
+        } else if (options.selectivity >= 0) {
+            int attempt = 0;
+            do {
+                code = (uint32_t) indexes.index(j, generator);
+            } while (predicate.matches(code) && ++attempt < 64);
+            if (predicate.matches(code)) code = predicate.nonMatchingCode(generator, column.bitWidth);
+        } else if (drawCodes) {
+            code = (uint32_t) indexes.index(j, generator);
+        }
+        column.set(j, code);
+    }
+}
 
-template <class T>
-void threadFunc(vector<T>& elements, int colCount, size_t startIndex, size_t endIndex, int threadId, int iterations, int sampleSize){
-    while (!threadFlag){};
-    for (int s = 0; s < sampleSize; s++) {
+// Row ranges of the threads: every thread gets the same number of *granularity* sized units, give or take one
+static vector<size_t> partitionBounds(size_t rows, int threadCount, size_t granularity) {
+    size_t units = (rows + granularity - 1) / granularity;
+    size_t partLength = units / threadCount, overhang = units % threadCount;
+    vector<size_t> bounds = {0};
+    for (int j = 0; j < threadCount; j++) {
+        bounds.push_back(min(rows, bounds.back() + (partLength + (j < overhang ? 1 : 0)) * granularity));
+    }
+    return bounds;
+}
+
+// per thread and sample
+static vector<vector<long long int>> threadTimes;
+static vector<vector<long long int>> threadCountTimes; // same scan without materialization, to isolate the write cost
+static vector<uint64_t> threadMatches;
+static vector<vector<uint64_t>> threadSampleMatches; // what scan() returned per sample, e.g. the updates of a writer
+static vector<CounterEvent> counterEvents;
+static vector<vector<double>> threadCounters; // counterEvents.size() values per sample, per scan
+// Scans made of phases add the time of each phase to threadPhaseNanos, which is reset for every sample
+static vector<vector<long long int>> threadPhaseNanos;
+static vector<vector<double>> threadPhaseTimes; // threadPhaseNanos[j].size() values per sample, per scan
+
+// Decided by thread 0 between two barriers, so all threads run the same iterations and samples
+static struct {
+    int iterations;
+    bool done;
+} samplingControl;
+
+// Enabled hardware prefetchers of the CSV rows, see PrefetcherControl
+static string prefetcherLabel = "unchanged";
+static int prefetcherMask = -1; // of the JSON records, -1 if unknown
+
+// Cache state every sample starts in, see cache_control.h
+static CacheState cacheState = CacheState::Warm;
+static vector<unique_ptr<CacheControl>> cacheControls; // per thread, made by the thread when it first needs it
+
+// Untimed work of a thread before each of its passes, e.g. dropping a file from the page cache. A sample is then a
+// single pass, as with a cold or llc-only cacheState. Reset with the measurements.
+static function<void(int)> passPreparation;
+// Untimed work of a thread before each iteration of a sample, e.g. handing out the morsels again. Unlike a
+// passPreparation, it keeps the iterations. Reset with the measurements.
+static function<void(int)> iterationPreparation;
+
+// CSV with a header line, or a JSON record per sample that carries the metadata of the run
+static OutputFormat outputFormat = OutputFormat::Csv;
+static RunMetadata runMetadata;
+
+// Measured before the sizes with --roofline, empty otherwise
+static Roofline roofline;
+
+// Created once in main, so that every benchmark runs on the same pinned threads
+static unique_ptr<WorkerPool> workerPool;
+
+// Distinct nodes in ascending order
+static vector<int> distinctNodes(vector<int> nodes) {
+    sort(nodes.begin(), nodes.end());
+    nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+    return nodes;
+}
+
+// NUMA nodes of the CPUs the workers are pinned to
+static vector<int> workerNodes() {
+    vector<int> nodes;
+    for (auto cpu: workerPool->cpus()) nodes.push_back(cpuNode(cpu));
+    return distinctNodes(nodes);
+}
+
+static string cpuNodeLabel() {
+    return nodeLabel(workerNodes());
+}
+
+// NUMA nodes the data of a benchmark is placed on
+static vector<int> memoryNodes(const ScanOptions &options) {
+    return options.placement == Placement::Local ? workerNodes()
+         : options.placement == Placement::Node ? vector<int>{options.memoryNode}
+         : distinctNodes(onlineNodes());
+}
+
+static string memoryNodesName(const ScanOptions &options) {
+    return nodeLabel(memoryNodes(options));
+}
+
+// CSV columns of every mode, filled by placementColumns(), summaryColumns() and printCounters()
+static const char *const PLACEMENT_HEADER = "Placement,CPU nodes,Memory nodes,Pages,Prefetchers,Cache state";
+static const char *const SUMMARY_HEADER = "Median time in ns,P5 time in ns,P95 time in ns,Stddev time in ns,Samples";
+
+// Where the threads ran and the data lay, and the state of the prefetchers and caches
+static string placementColumns(const ScanOptions &options) {
+    return placementName(options.placement) + "," + cpuNodeLabel() + "," + memoryNodesName(options) + ","
+           + pageModeName(options.pages) + "," + prefetcherLabel + "," + cacheStateName(cacheState);
+}
+
+static string summaryColumns(const SampleSummary &summary) {
+    ostringstream columns;
+    columns << summary.median << "," << summary.p5 << "," << summary.p95 << "," << summary.stddev << ","
+            << summary.count;
+    return columns.str();
+}
+
+// One column per counter, empty if it could not be counted. Counts are rounded unless they are *fractional*.
+static void printCounters(const vector<double> &values, bool fractional = false) {
+    for (auto value: values) {
+        cout << ",";
+        if (std::isnan(value)) continue;
+        if (fractional) cout << value;
+        else cout << llround(value);
+    }
+}
+
+// Time of every thread in one sample
+static vector<long long int> sampleThreadTimes(size_t sample) {
+    vector<long long int> times;
+    for (auto &thread: threadTimes) times.push_back(thread[sample]);
+    return times;
+}
+
+/*
+ * First fields of the JSON record of a sample: the run, the size in bytes, where the threads ran and the data lay, and
+ * the time of every thread of the sample.
+ */
+static JsonRecord sampleRecord(size_t sizeBytes, size_t sample,
+                               const vector<long long int> &threadNanos, const ScanOptions &options) {
+    auto record = runMetadata.record();
+    record.field("size_bytes", sizeBytes).field("threads", (int) threadNanos.size())
+          .field("cpus", workerPool->cpus()).field("cpu_nodes", workerNodes())
+          .field("placement", placementName(options.placement)).field("memory_nodes", memoryNodes(options))
+          .field("pages", pageModeName(options.pages)).field("cache_state", cacheStateName(cacheState));
+    if (prefetcherMask >= 0) record.field("prefetchers", prefetcherMask);
+    else record.null("prefetchers");
+    record.field("distribution", distributionName(options.generator.distribution))
+          .field("seed", options.generator.seed).field("sample", sample).field("thread_times_ns", threadNanos);
+    return record;
+}
+
+// Counts of one sample, summed over the threads, NaN if a thread could not count the event
+static vector<double> sampleCounters(size_t sample) {
+    vector<double> counters(counterEvents.size(), 0);
+    for (auto &thread: threadCounters) {
+        for (size_t e = 0; e < counters.size(); e++) counters[e] += thread[sample * counters.size() + e];
+    }
+    return counters;
+}
+
+// One field per counter, null if it could not be counted
+static void addCounters(JsonRecord &record, const vector<double> &values) {
+    for (size_t e = 0; e < counterEvents.size(); e++) record.field("counter_" + counterEvents[e].name, values[e]);
+}
+
+/*
+ * Decides where the pages of a table go, before the threads generate their partitions. With local placement the page
+ * goes to the node of the thread that generates it, which is the thread that scans it.
+ */
+static void placeTable(void *memory, size_t bytes, const ScanOptions &options) {
+    // hugetlbfs mappings can only be bound in whole pages
+    bytes = alignUp(bytes, ColumnAllocator::hugePageBytes(options.pages));
+    if (!placeMemory(memory, bytes, options.placement, options.memoryNode)) {
+        cerr << "cannot place the table on memory node " << options.memoryNode << endl;
+        exit(1);
+    }
+}
+
+// Thread times of one sample, averaged over the threads
+static vector<double> averageSampleTimes() {
+    vector<double> times(threadTimes[0].size(), 0);
+    for (auto &thread: threadTimes) {
+        for (size_t s = 0; s < times.size(); s++) times[s] += (double) thread[s] / threadTimes.size();
+    }
+    return times;
+}
+
+// Run by thread 0 after every sample
+static bool samplingDone(const SamplingOptions &sampling, chrono::high_resolution_clock::time_point begin) {
+    size_t samples = threadTimes[0].size();
+    if (samples < (size_t) sampling.sampleSize) {
+        return false;
+    } else if (sampling.relError <= 0) {
+        return true;
+    }
+    chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - begin;
+    return medianRelativeError(averageSampleTimes()) <= sampling.relError || elapsed.count() >= sampling.timeBudget;
+}
+
+static long long int elapsedNanos(chrono::high_resolution_clock::time_point start,
+                                  chrono::high_resolution_clock::time_point end) {
+    return chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+}
+
+// Whether every sample is a single pass that is prepared first
+static bool singlePasses() {
+    return cacheState != CacheState::Warm || passPreparation;
+}
+
+// Brings the caches of thread *threadId* into cacheState and runs the passPreparation, the pool may be new since the
+// last sample
+static void preparePass(int threadId) {
+    if (cacheState != CacheState::Warm) {
+        auto &control = cacheControls[threadId];
+        int cpu = workerPool->cpus()[threadId];
+        if (!control || control->cpu() != cpu) control.reset(new CacheControl(cpu, workerPool->cpus()));
+        control->prepare(cacheState, threadId, (int) cacheControls.size());
+    }
+    if (passPreparation) passPreparation(threadId);
+}
+
+/*
+ * Runs run() *iterations* times, adds what it returns to *count* and returns the time of all runs. The
+ * iterationPreparation runs before each of them, outside of the time and of the *counters*.
+ */
+template <class Run>
+static chrono::nanoseconds timeIterations(int threadId, int iterations, Run &run, uint64_t &count,
+                                          CounterGroup *counters = nullptr) {
+    if (!iterationPreparation) {
+        if (counters) counters->start();
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            count += run();
+        }
+        auto end = chrono::high_resolution_clock::now();
+        if (counters) counters->stop();
+        return chrono::duration_cast<chrono::nanoseconds>(end - start);
+    }
+    chrono::nanoseconds time(0);
+    for (int i = 0; i < iterations; i++) {
+        iterationPreparation(threadId);
+        if (counters && i == 0) counters->start();
+        else if (counters) counters->resume();
+        auto start = chrono::high_resolution_clock::now();
+        count += run();
+        auto end = chrono::high_resolution_clock::now();
+        if (counters) counters->stop();
+        time += chrono::duration_cast<chrono::nanoseconds>(end - start);
+    }
+    return time;
+}
+
+/*
+ * Runs scan() *iterations* times per sample, scan() returns the number of qualifying rows. Scans that materialize
+ * their result are followed by the same number of runs of the count-only reference(). Unless the caches are warm and
+ * there is no passPreparation, a sample is a single run, after all threads prepared it.
+ */
+template <class Scan, class Reference>
+static void measureThread(int threadId, const SamplingOptions &sampling, bool materializes, Scan scan,
+                          Reference reference) {
+    auto begin = chrono::high_resolution_clock::now();
+    auto &times = threadTimes[threadId];
+    auto &countTimes = threadCountTimes[threadId];
+
+    // doubles the iterations, or scales them up to the target, until the threads take long enough on average
+    while (sampling.iterations == 0 && !singlePasses()) {
+        workerPool->barrier();
+        if (samplingControl.done) break;
+        int iterations = samplingControl.iterations;
+        uint64_t count = 0;
+        times.assign(1, timeIterations(threadId, iterations, scan, count).count());
+        doNotOptimize(count);
+        workerPool->barrier();
+        if (threadId == 0) {
+            double time = averageSampleTimes()[0] / 1e9, target = sampling.minSampleTime;
+            double factor = time > 0 ? min(10.0, max(2.0, 1.1 * target / time)) : 10;
+            samplingControl.done = time >= target || iterations >= INT_MAX / 10;
+            if (!samplingControl.done) samplingControl.iterations = (int) (iterations * factor);
+        }
+    }
+    const int iterations = singlePasses() ? 1
+                         : sampling.iterations == 0 ? samplingControl.iterations : sampling.iterations;
+    times.clear();
+
+    // opening is not cheap, so it happens before the first sample and the group only counts the timed loop
+    CounterGroup counters(counterEvents);
+    workerPool->barrier();
+    if (threadId == 0) samplingControl.done = false;
+    for (int s = 0; ; s++) {
       uint64_t count = 0;
-      auto start = chrono::high_resolution_clock::now();
-      for (int i = 0; i < iterations; i++) {
-          for (size_t j = startIndex; j < endIndex; j++) {
-              auto element = elements[j * colCount + 0]; // read first column
-              if (element == 0) count++;
+      // all threads start every sample together, after thread 0 decided whether there is one
+      workerPool->barrier();
+      if (samplingControl.done) break;
+      auto &phaseNanos = threadPhaseNanos[threadId];
+      fill(phaseNanos.begin(), phaseNanos.end(), 0);
+      if (singlePasses()) {
+          preparePass(threadId);
+          workerPool->barrier();
+      }
+      auto time = timeIterations(threadId, iterations, scan, count, &counters);
+      threadMatches[threadId] = count / iterations;
+      doNotOptimize(count);
+      auto values = counters.read();
+
+      long long int countTime = time.count() / iterations;
+      if (materializes) {
+          if (singlePasses()) {
+              workerPool->barrier();
+              preparePass(threadId);
+              workerPool->barrier();
           }
+          uint64_t referenceCount = 0;
+          countTime = timeIterations(threadId, iterations, reference, referenceCount).count() / iterations;
+          doNotOptimize(referenceCount);
+      }
+
+      // warm-up samples fill caches, TLBs and branch predictors and are not kept
+      if (s >= sampling.warmupSamples) {
+          times.push_back(time.count() / iterations);
+          countTimes.push_back(countTime);
+          threadSampleMatches[threadId].push_back(count / iterations);
+          for (auto value: values) threadCounters[threadId].push_back(value / iterations);
+          for (auto nanos: phaseNanos) threadPhaseTimes[threadId].push_back((double) nanos / iterations);
       }
-      auto end = chrono::high_resolution_clock::now();
-      auto time = chrono::duration_cast<chrono::nanoseconds>(end - start);
-      threadTimes[threadId*sampleSize + s] = time.count() / iterations;
-      cerr << "o3Trick" << count << endl; // volatile uint64_t o3Trick = count;
+      workerPool->barrier();
+      if (threadId == 0) samplingControl.done = s >= sampling.warmupSamples && samplingDone(sampling, begin);
     }
 }
 
+/*
+ * Scans rows [startIndex, endIndex), or with a *scheduler* morsels until there are none left. The morsels are handed
+ * out again by the iterationPreparation, and a morsel scan adds the time the thread scanned to threadPhaseNanos.
+ */
 template <class T>
-void printResults(vector<long long int> times, size_t size, int threadCount, int colCount) {
-    auto dataType = "int" + to_string(sizeof(T) * 8);
+void threadFunc(const ColumnBuffer<T>& elements, int colCount, size_t colLength, size_t startIndex, size_t endIndex,
+                int threadId, const SamplingOptions &sampling, const ScanOptions &options,
+                const Predicate<T> &predicate, MorselScheduler *scheduler){
+    vector<const T*> columns;
+    for (int c = 0; c < options.predicateColumns; c++) {
+        columns.push_back(elements.data() + elementIndex(0, c, columnStride<T>(colLength), colCount));
+    }
+    size_t stride = colCount > 1 ? colCount : 1;
+
+    if (scheduler) {
+        auto &busy = threadPhaseNanos[threadId];
+        measureThread(threadId, sampling, false, [&]() {
+            auto start = chrono::high_resolution_clock::now();
+            uint64_t count = 0;
+            uint32_t morsel;
+            while (scheduler->next(threadId, morsel)) {
+                size_t begin = morsel * options.morselRows, end = min(colLength, begin + options.morselRows);
+                count += countMatches<T>(options.kernel, options.branchMode, columns.data(), columns.size(), stride,
+                                         begin, end, predicate);
+            }
+            busy[0] += elapsedNanos(start, chrono::high_resolution_clock::now());
+            return count;
+        }, []() {
+            return (uint64_t) 0;
+        });
+        return;
+    }
+
+    // pre-allocated and touched here, so neither allocation nor page faults end up in the measurement
+    auto bufferBytes = outputBufferBytes(options.outputMode, endIndex - startIndex, sizeof(T));
+    ColumnBuffer<uint64_t> buffer((bufferBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), options.pages);
+    memset(buffer.data(), 0, buffer.sizeInBytes());
+
+    measureThread(threadId, sampling, options.outputMode != OutputMode::Count, [&]() {
+        auto count = scanInto<T>(options.outputMode, options.kernel, options.branchMode, columns.data(),
+                                 columns.size(), stride, startIndex, endIndex, predicate, buffer.data());
+        doNotOptimize(buffer.data());
+        return count;
+    }, [&]() {
+        return countMatches<T>(options.kernel, options.branchMode, columns.data(), columns.size(), stride,
+                               startIndex, endIndex, predicate);
+    });
+}
+
+// per thread, the GROUP BY table of its last scan
+static vector<vector<AggregateResult>> threadGroups;
+
+/*
+ * Aggregates rows [startIndex, endIndex) of a column store column, or groups them by *keys* into a table of the
+ * thread. The table starts empty on every scan, the tables of the threads are merged after the measurement.
+ */
+template <class T>
+void aggregateThreadFunc(const T *column, const uint32_t *keys, size_t startIndex, size_t endIndex, int threadId,
+                         const SamplingOptions &sampling, const ScanOptions &options, const Predicate<T> &predicate) {
+    auto &groups = threadGroups[threadId];
+    groups.assign(options.groups, AggregateResult());
+
+    measureThread(threadId, sampling, false, [&]() {
+        if (options.groups == 0) {
+            auto result = aggregateColumn(options.kernel, options.aggregate, column, startIndex, endIndex,
+                                          options.filtered, predicate);
+            doNotOptimize(result);
+            return result.count;
+        }
+        fill(groups.begin(), groups.end(), AggregateResult());
+        aggregateGroups(keys, column, startIndex, endIndex, options.filtered, predicate, groups.data());
+        doNotOptimize(groups.data());
+        uint64_t count = 0;
+        for (auto &group: groups) count += group.count;
+        return count;
+    }, []() {
+        return (uint64_t) 0;
+    });
+}
+
+// Writes the GROUP BY keys of rows [begin, end), drawn from the distribution with --group-by distinct values
+static void generateKeys(uint32_t *keys, size_t colLength, size_t begin, size_t end, const ScanOptions &options) {
+    auto keyOptions = options.generator;
+    keyOptions.cardinality = options.groups;
+    // uniform draws from the whole domain, lowcard uniformly from the first *cardinality* values
+    if (keyOptions.distribution == Distribution::Uniform) keyOptions.distribution = Distribution::LowCardinality;
+    IndexGenerator indexes(keyOptions, colLength, options.groups);
+    for (size_t j = begin; j < end; j++) {
+        // the key column follows the aggregated one
+        auto generator = indexes.generator(j, 1);
+        keys[j] = (uint32_t) indexes.index(j, generator);
+    }
+}
+
+void packedThreadFunc(const PackedColumn &column, size_t startIndex, size_t endIndex, int threadId,
+                      const SamplingOptions &sampling, const ScanOptions &options, const CodePredicate &predicate) {
+    auto bufferBytes = outputBufferBytes(options.outputMode, endIndex - startIndex, sizeof(uint32_t));
+    ColumnBuffer<uint64_t> buffer((bufferBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), options.pages);
+    memset(buffer.data(), 0, buffer.sizeInBytes());
+
+    measureThread(threadId, sampling, options.outputMode != OutputMode::Count, [&]() {
+        auto count = scanPackedInto(options.outputMode, options.kernel, options.branchMode, column, startIndex,
+                                    endIndex, predicate, buffer.data());
+        doNotOptimize(buffer.data());
+        return count;
+    }, [&]() {
+        return scanPackedInto(OutputMode::Count, options.kernel, options.branchMode, column, startIndex, endIndex,
+                              predicate, nullptr);
+    });
+}
+
+static void resetMeasurements(int threadCount, const SamplingOptions &sampling, size_t phases = 0) {
+    threadTimes.assign(threadCount, {});
+    threadCountTimes.assign(threadCount, {});
+    threadMatches.assign(threadCount, 0);
+    threadSampleMatches.assign(threadCount, {});
+    threadCounters.assign(threadCount, {});
+    threadPhaseNanos.assign(threadCount, vector<long long int>(phases, 0));
+    threadPhaseTimes.assign(threadCount, {});
+    samplingControl.iterations = max(1, sampling.iterations);
+    cacheControls.resize(threadCount);
+    passPreparation = nullptr;
+    iterationPreparation = nullptr;
+    samplingControl.done = false;
+}
+
+// Measurements of one table, averaged over the threads
+struct Results {
+    string dataType;
+    string packing;
+    vector<long long int> times;
+    vector<long long int> writeTimes;
+    vector<long long int> makespans; // of the slowest thread
+    vector<long long int> maxThreadTimes; // time a thread scanned, which leaves out the waiting of morsel scans
+    vector<long long int> minThreadTimes;
+    vector<vector<long long int>> threadTimes; // per sample, of every thread
+    vector<vector<double>> counters; // per sample, summed over the threads
+    SampleSummary summary; // of times
+    size_t rows;
+    size_t scannedBytes; // bytes of the table the scan has to read
+    size_t valueBytes; // of the compared values, 0 if they differ in width or are packed
+    double selectivity;
+    size_t outputBytes;
+};
+
+static Results collectResults(const string &dataType, const string &packing, const vector<size_t> &bounds,
+                              OutputMode outputMode, size_t elementSize, size_t scannedBytes) {
+    int threadCount = bounds.size() - 1;
+    Results results;
+    results.dataType = dataType;
+    results.packing = packing;
+    // Average per run
+    for (size_t s=0; s < threadTimes[0].size(); s++) {
+        long long int time = 0, writeTime = 0;
+        for (int j=0; j<threadCount; j++) {
+            time += threadTimes[j][s];
+            writeTime += threadTimes[j][s] - threadCountTimes[j][s];
+        }
+        results.times.push_back(time / threadCount);
+        results.writeTimes.push_back(writeTime / threadCount);
+
+        long long int makespan = 0, maxThreadTime = 0, minThreadTime = LLONG_MAX;
+        for (int j=0; j<threadCount; j++) {
+            long long int busy = threadPhaseTimes[j].empty() ? threadTimes[j][s] : llround(threadPhaseTimes[j][s]);
+            makespan = max(makespan, threadTimes[j][s]);
+            maxThreadTime = max(maxThreadTime, busy);
+            minThreadTime = min(minThreadTime, busy);
+        }
+        results.makespans.push_back(makespan);
+        results.maxThreadTimes.push_back(maxThreadTime);
+        results.minThreadTimes.push_back(minThreadTime);
+        results.threadTimes.push_back(sampleThreadTimes(s));
+
+        // event counts of the whole table
+        results.counters.push_back(sampleCounters(s));
+    }
+    results.summary = summarize(vector<double>(results.times.begin(), results.times.end()));
+
+    // measured on the data, so it also shows the effective selectivity of the plain 0- and random-initialization
+    auto matches = accumulate(threadMatches.begin(), threadMatches.end(), (uint64_t) 0);
+    results.rows = bounds.back();
+    results.scannedBytes = scannedBytes;
+    results.valueBytes = 0;
+    results.selectivity = (double) matches / results.rows;
+    results.outputBytes = 0;
+    for (int j = 0; j < threadCount; j++) {
+        results.outputBytes += outputBytesWritten(outputMode, bounds[j + 1] - bounds[j], threadMatches[j],
+                                                  elementSize);
+    }
+    return results;
+}
+
+// *dbType* is the layout of the table, e.g. "Column store", *layout* its name in JSON records, e.g. "column"
+void printResults(const Results &results, size_t size, int threadCount, const string &dbType, const string &layout,
+                  const ScanOptions &options) {
     auto threadCountStr = to_string(threadCount) + " threads";
-    auto rowStoreStr = colCount > 1 ? "Row store" : "Column store";
-    for (auto &time: times) {
-        cout << (size / 1024.0f) << "," << dataType << "," << time << "," << threadCountStr << "," << rowStoreStr << endl;
+    auto kernelStr = scanKernelName(options.kernel);
+    // the vector kernels never branch on the predicate, neither does the scalar kernel on vertically packed codes
+    bool branchFree = options.kernel != ScanKernel::Scalar || results.packing == packingName(Packing::Vertical);
+    auto branchingStr = branchFree ? "branch-free" : branchModeName(options.branchMode);
+    auto scheduling = options.morselRows > 0 ? to_string(options.morselRows) + " row morsels" : string("static");
+    auto placement = placementColumns(options);
+    // cold scans read from DRAM and llc-only scans at best from the last level cache
+    string rooflineLimit;
+    double rooflineBytes = NAN;
+    if (!roofline.empty()) {
+        size_t caches = roofline.levels.size() - 1;
+        size_t firstLevel = cacheState == CacheState::Cold ? caches
+                          : cacheState == CacheState::LlcOnly && caches > 0 ? caches - 1 : 0;
+        rooflineBytes = roofline.bound(results.scannedBytes, results.valueBytes, firstLevel, rooflineLimit);
+    }
+    for (size_t s = 0; s < results.times.size(); s++) {
+        // threads scan their parts concurrently, so the whole table takes the average thread time
+        double seconds = max<long long int>(results.times[s], 1) / 1e9;
+        double fraction = results.scannedBytes / seconds / rooflineBytes;
+        if (outputFormat == OutputFormat::Json) {
+            auto record = sampleRecord(size, s, results.threadTimes[s], options);
+            record.field("data_type", results.dataType).field("layout", layout).field("kernel", kernelStr)
+                  .field("predicate", predicateTypeName(options.predicateType))
+                  .field("predicate_columns", options.predicateColumns).field("branching", branchingStr);
+            if (options.selectivity >= 0) record.field("target_selectivity", options.selectivity);
+            else record.null("target_selectivity");
+            record.field("selectivity", results.selectivity).field("output", outputModeName(options.outputMode))
+                  .field("packing", results.packing).field("aggregate", aggregateLabel(options))
+                  .field("morsel_rows", options.morselRows).field("rows", results.rows)
+                  .field("scanned_bytes", results.scannedBytes).field("output_bytes", results.outputBytes)
+                  .field("time_ns", results.times[s]).field("write_time_ns", results.writeTimes[s])
+                  .field("makespan_ns", results.makespans[s]).field("max_thread_time_ns", results.maxThreadTimes[s])
+                  .field("min_thread_time_ns", results.minThreadTimes[s])
+                  .field("tuples_per_second", results.rows / seconds)
+                  .field("bytes_per_second", results.scannedBytes / seconds);
+            if (!rooflineLimit.empty()) record.field("roofline_limit", rooflineLimit);
+            else record.null("roofline_limit");
+            record.field("roofline_bytes_per_second", rooflineBytes).field("roofline_fraction", fraction);
+            addCounters(record, results.counters[s]);
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << results.dataType << "," << results.times[s] << "," << threadCountStr << ","
+             << dbType << "," << kernelStr << "," << predicateTypeName(options.predicateType) << ","
+             << options.predicateColumns << "," << branchingStr << "," << results.selectivity << ","
+             << outputModeName(options.outputMode) << "," << results.writeTimes[s] << "," << results.outputBytes
+             << "," << results.packing << "," << results.rows << "," << results.rows / seconds << ","
+             << results.scannedBytes / seconds << "," << placement << ","
+             << distributionName(options.generator.distribution) << "," << aggregateLabel(options) << ","
+             << summaryColumns(results.summary) << "," << scheduling << "," << results.makespans[s] << ","
+             << results.maxThreadTimes[s] << "," << results.minThreadTimes[s] << "," << rooflineLimit << ",";
+        if (!std::isnan(rooflineBytes)) cout << rooflineBytes << "," << fraction;
+        else cout << ",";
+        printCounters(results.counters[s]);
+        cout << endl;
     };
 }
 
 template <class T>
-void benchmark(size_t colSize, int colCount, int threadCount, int iterations, int sampleSize, bool randomInit) {
+Results benchmark(size_t colSize, int colCount, int threadCount, const SamplingOptions &sampling, bool randomInit,
+                  ScanOptions options) {
     const size_t colLength = colSize / sizeof(T);
+    // strided row store scans cannot use the vector kernels
+    if (colCount > 1) options.kernel = ScanKernel::Scalar;
+    // GROUP BY is scalar and branches on the filter, the other scalar aggregates are predicated
+    if (options.groups > 0) options.kernel = ScanKernel::Scalar;
+    if (options.aggregate != Aggregate::None) {
+        options.branchMode = options.groups > 0 ? BranchMode::Branchy : BranchMode::Predicated;
+    }
 
-    // Split array into *threadCount* sequential parts
-    vector<thread*> threads;
-    size_t partLength = colLength / threadCount, overhang = colLength % threadCount;
+    // Split array into *threadCount* sequential parts, of whole morsels with a scheduler
+    auto bounds = partitionBounds(colLength, threadCount, max<size_t>(1, options.morselRows));
 
-    auto attributeVector = generateData<T>(colLength * colCount, randomInit);
-    threadTimes.resize(threadCount*sampleSize);
+    auto predicate = makePredicate<T>(options.predicateType, options.inListSize);
+    ColumnBuffer<T> attributeVector(tableElements<T>(colLength, colCount, options), options.pages);
+    placeTable(attributeVector.data(), attributeVector.sizeInBytes(), options);
+    workerPool->run([&](int j) {
+        generateRows<T>(attributeVector.data(), colLength, colCount, bounds[j], bounds[j + 1], randomInit, options,
+                        predicate);
+    });
+    ColumnBuffer<uint32_t> keys(options.groups > 0 ? colLength : 0, options.pages);
+    if (options.groups > 0) {
+        placeTable(keys.data(), keys.sizeInBytes(), options);
+        workerPool->run([&](int j) {
+            generateKeys(keys.data(), colLength, bounds[j], bounds[j + 1], options);
+        });
+    }
+    unique_ptr<MorselScheduler> scheduler;
+    if (options.morselRows > 0) {
+        vector<uint32_t> firstMorsels;
+        vector<int> nodes;
+        // the bounds are whole morsels, but for the end of the column
+        for (auto bound: bounds) {
+            firstMorsels.push_back((uint32_t) ((bound + options.morselRows - 1) / options.morselRows));
+        }
+        for (auto cpu: workerPool->cpus()) nodes.push_back(cpuNode(cpu));
+        scheduler.reset(new MorselScheduler(firstMorsels, nodes));
+    }
+    resetMeasurements(threadCount, sampling, scheduler ? 1 : 0);
+    if (scheduler) {
+        // once all threads are done with the last scan, and before any takes a morsel of the next
+        iterationPreparation = [&](int j) {
+            workerPool->barrier();
+            scheduler->reset(j);
+            workerPool->barrier();
+        };
+    }
 
-    size_t startIndex = 0;
-    for (int j = 0; j < threadCount - 1; j++) {
-        size_t endIndex = startIndex + partLength + (j < overhang ? 1 : 0);
-        auto threadInstance = new thread(threadFunc<T>, ref(attributeVector), colCount, startIndex,
-                                         endIndex, j, iterations, sampleSize);
-        threads.push_back(threadInstance);
-        startIndex = endIndex;
+    if (options.aggregate != Aggregate::None) {
+        threadGroups.assign(threadCount, {});
+        workerPool->run([&](int j) {
+            aggregateThreadFunc<T>(attributeVector.data(), keys.data(), bounds[j], bounds[j + 1], j, sampling,
+                                   options, predicate);
+        });
+        vector<AggregateResult> groups(options.groups);
+        for (auto &table: threadGroups) {
+            for (size_t g = 0; g < groups.size(); g++) groups[g].merge(table[g]);
+        }
+        doNotOptimize(groups.data());
+    } else {
+        workerPool->run([&](int j) {
+            threadFunc<T>(attributeVector, colCount, colLength, bounds[j], bounds[j + 1], j, sampling, options,
+                          predicate, scheduler.get());
+        });
     }
 
+    // a row store scan streams whole rows through the caches
+    auto scannedBytes = colLength * sizeof(T) * (colCount > 1 ? colCount : options.predicateColumns);
+    scannedBytes += keys.sizeInBytes();
+    auto results = collectResults("int" + to_string(sizeof(T) * 8), "none", bounds, options.outputMode, sizeof(T),
+                                  scannedBytes);
+    results.valueBytes = sizeof(T);
+    printResults(results, colSize, threadCount, colCount > 1 ? "Row store" : "Column store",
+                 colCount > 1 ? "row" : "column", options);
+    return results;
+}
 
-    // run threadFunc on main thread
-    int j = threadCount - 1;
-    size_t endIndex = startIndex + partLength + (j < overhang ? 1 : 0);
+/*
+ * Scans a dictionary-encoded column of bitWidth bit codes that takes colSize bytes, so narrower codes mean more rows.
+ * The dictionary is the dense domain of a signed bitWidth bit integer, the predicate is translated into codes once.
+ */
+Results benchmarkPacked(unsigned bitWidth, size_t colSize, int threadCount, const SamplingOptions &sampling,
+                        bool randomInit, ScanOptions options) {
+    const size_t rows = colSize * 8 / bitWidth;
+    // horizontally packed codes are only decoded by the scalar kernel
+    if (options.packing == Packing::Horizontal) options.kernel = ScanKernel::Scalar;
+    unsigned lanes = packedLanes(options.kernel);
 
-    threadFlag = true;
-    threadFunc<T>(attributeVector, colCount, startIndex, endIndex, j, iterations, sampleSize);
+    auto dictionary = Dictionary<int64_t>::dense(-((int64_t) 1 << (bitWidth - 1)), (uint64_t) 1 << bitWidth);
+    auto predicate = dictionary.translate(makePredicate<int64_t>(options.predicateType, options.inListSize));
+    PackedColumn column(options.packing, bitWidth, rows, lanes, options.pages);
+    // partitions start on a word (horizontal) or block (vertical) boundary, so no two threads write the same word
+    auto bounds = partitionBounds(rows, threadCount, options.packing == Packing::Vertical ? column.blockRows() : 32);
+    placeTable(column.words.data(), column.words.sizeInBytes(), options);
+    uint32_t zeroCode;
+    dictionary.encode(0, zeroCode);
+    workerPool->run([&](int j) {
+        generatePackedRows(column, bounds[j], bounds[j + 1], randomInit, options, zeroCode, predicate);
+    });
+    resetMeasurements(threadCount, sampling);
 
-    for (thread *thread: threads) {
-        (*thread).join();
+    workerPool->run([&](int j) {
+        packedThreadFunc(column, bounds[j], bounds[j + 1], j, sampling, options, predicate);
+    });
+
+    auto results = collectResults("packed" + to_string(bitWidth), packingName(options.packing), bounds,
+                                  options.outputMode, sizeof(uint32_t), column.bytes());
+    printResults(results, colSize, threadCount, "Column store", "column", options);
+    return results;
+}
+
+// Writes rows [begin, end) of an attribute of a table, the same way generateRows() writes a column store column
+template <class T>
+static void generateAttribute(char *table, const TableLayout &layout, int attribute, size_t begin, size_t end,
+                              bool randomInit, const ScanOptions &options, const Predicate<T> &predicate) {
+    const auto &generatorOptions = options.generator;
+    const bool drawValues = randomInit || generatorOptions.distribution != Distribution::Uniform;
+    IndexGenerator indexes(generatorOptions, layout.rows, domainSize<T>());
+    RowSelection selection(layout.rows, max(0.0, options.selectivity), generatorOptions);
+    for (size_t j = begin; j < end; j++) {
+        auto generator = indexes.generator(j, attribute);
+        T value = 0;
+        if (options.selectivity >= 0) {
+            value = selection.qualifies(j) ? predicate.matchingValue(generator)
+                                           : nonMatchingValue(indexes, j, generator, predicate);
+        } else if (drawValues) {
+            value = domainValue<T>(indexes.index(j, generator), indexes.size());
+        }
+        memcpy(table + layout.offset(j, attribute), &value, sizeof(T));
     }
+}
 
-    while (!threads.empty()) {
-        delete threads.back();
-        threads.pop_back();
+/*
+ * Scans the first k attributes of a --schema table in one layout, for every k of --attributes. The rows of all
+ * layouts take colSize bytes without padding, so the layouts hold the same rows. With a selectivity target the
+ * qualifying rows satisfy the predicate on every attribute and the others on none, so every k sees the target.
+ */
+static void benchmarkTable(Layout layoutType, size_t colSize, const vector<unsigned> &widths,
+                           const vector<int> &attributeCounts, size_t groupRows, int threadCount,
+                           const SamplingOptions &sampling, bool randomInit, ScanOptions options) {
+    // chunks of rows evaluated one attribute after another, into match flags
+    options.kernel = ScanKernel::Scalar;
+    options.branchMode = BranchMode::Predicated;
+    options.outputMode = OutputMode::Count;
+    size_t rowBytes = accumulate(widths.begin(), widths.end(), (size_t) 0);
+    TableLayout layout(layoutType, widths, max<size_t>(1, colSize / rowBytes), groupRows);
+    // row groups are not split between threads, and no two threads write the same cache line of a column
+    auto bounds = partitionBounds(layout.rows, threadCount, layoutType == Layout::PAX ? groupRows : 64);
+    TablePredicates predicates{makePredicate<int8_t>(options.predicateType, options.inListSize),
+                               makePredicate<int16_t>(options.predicateType, options.inListSize),
+                               makePredicate<int32_t>(options.predicateType, options.inListSize),
+                               makePredicate<int64_t>(options.predicateType, options.inListSize)};
+
+    ColumnBuffer<char> table(layout.bytes(), options.pages);
+    placeTable(table.data(), table.sizeInBytes(), options);
+    workerPool->run([&](int j) {
+        for (int a = 0; a < layout.attributes(); a++) {
+            switch (layout.width(a)) {
+                case 1: generateAttribute(table.data(), layout, a, bounds[j], bounds[j + 1], randomInit, options,
+                                          predicates.int8); break;
+                case 2: generateAttribute(table.data(), layout, a, bounds[j], bounds[j + 1], randomInit, options,
+                                          predicates.int16); break;
+                case 4: generateAttribute(table.data(), layout, a, bounds[j], bounds[j + 1], randomInit, options,
+                                          predicates.int32); break;
+                default: generateAttribute(table.data(), layout, a, bounds[j], bounds[j + 1], randomInit, options,
+                                           predicates.int64); break;
+            }
+        }
+    });
+
+    string schema = "mixed";
+    for (auto width: widths) schema += "-" + to_string(width * 8);
+    auto dbType = layoutName(layoutType) + (layoutType == Layout::PAX ? " " + to_string(groupRows) + " rows" : "");
+    auto layoutKey = layoutName(layoutType);
+    transform(layoutKey.begin(), layoutKey.end(), layoutKey.begin(), ::tolower);
+    for (auto attributes: attributeCounts) {
+        attributes = min(attributes, layout.attributes());
+        resetMeasurements(threadCount, sampling);
+        workerPool->run([&](int j) {
+            measureThread(j, sampling, false, [&]() {
+                return scanTable(table.data(), layout, attributes, bounds[j], bounds[j + 1], predicates);
+            }, []() {
+                return (uint64_t) 0;
+            });
+        });
+
+        // NSM streams whole rows through the caches, the other layouts only the scanned attributes
+        size_t scannedBytes = layoutType == Layout::NSM ? layout.bytes()
+                            : layout.rows * accumulate(widths.begin(), widths.begin() + attributes, (size_t) 0);
+        auto results = collectResults(schema, "none", bounds, OutputMode::Count, rowBytes, scannedBytes);
+        options.predicateColumns = attributes;
+        printResults(results, colSize, threadCount, dbType, layoutKey, options);
     }
-    threadFlag = false;
+}
 
-    // Average per run
-    vector<long long int> times;
-    for (int s=0; s < sampleSize; s++) {
-        long long int time = 0;
-        for (int j=0; j<threadCount; j++)
-            time += threadTimes[j*sampleSize + s];
-        times.push_back(time / threadCount);
+// Latency of one load of a chain per sample, with the counters per load
+static void printLatencyResults(size_t size, int chains, size_t steps, int threadCount, const ScanOptions &options) {
+    auto times = averageSampleTimes();
+    vector<double> latencies;
+    for (auto time: times) latencies.push_back(time / steps);
+    auto summary = summarize(latencies);
+    auto cycles = find_if(counterEvents.begin(), counterEvents.end(), [](const CounterEvent &event) {
+        return event.name == "cycles";
+    }) - counterEvents.begin();
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < times.size(); s++) {
+        // summed over the threads, every thread loads steps * chains nodes per iteration
+        vector<double> counters(counterEvents.size(), 0);
+        for (int j = 0; j < threadCount; j++) {
+            for (size_t e = 0; e < counters.size(); e++) {
+                counters[e] += threadCounters[j][s * counters.size() + e] / (steps * chains * threadCount);
+            }
+        }
+        if (outputFormat == OutputFormat::Json) {
+            auto record = sampleRecord(size, s, sampleThreadTimes(s), options);
+            record.field("chains", chains).field("steps", steps).field("time_ns", times[s])
+                  .field("latency_ns", latencies[s]);
+            if (cycles < (long) counters.size()) record.field("latency_cycles", counters[cycles] * chains);
+            else record.null("latency_cycles");
+            addCounters(record, counters);
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << chains << "," << threadCount << " threads," << llround(times[s]) << ","
+             << latencies[s] << ",";
+        if (cycles < (long) counters.size() && !std::isnan(counters[cycles])) cout << counters[cycles] * chains;
+        cout << "," << placement << "," << summaryColumns(summary);
+        printCounters(counters, true);
+        cout << endl;
     }
+}
+
+/*
+ * Measures the latency of dependent loads on a working set of *size* bytes per thread, with *chains* chains followed
+ * at once. An iteration visits every node once, so a load of a chain takes the iteration time divided by the steps.
+ */
+static void benchmarkLatency(size_t size, int chains, int threadCount, const SamplingOptions &sampling,
+                             const ScanOptions &options) {
+    size_t count = max<size_t>(size / sizeof(ChainNode), chains);
+    size_t steps = count / chains;
+    ColumnBuffer<ChainNode> nodes(count * threadCount, options.pages);
+    placeTable(nodes.data(), nodes.sizeInBytes(), options);
+    resetMeasurements(threadCount, sampling);
 
-    printResults<T>(times, colSize, threadCount, colCount);
+    workerPool->run([&](int j) {
+        ChainNode *own = &nodes[j * count];
+        vector<const ChainNode*> starts;
+        {
+            auto order = linkCycle(own, count, options.generator.seed);
+            for (int c = 0; c < chains; c++) starts.push_back(&own[order[c * count / chains]]);
+        }
+        measureThread(j, sampling, false, [&]() {
+            return chaseChains(chains, starts.data(), steps);
+        }, []() {
+            return (uint64_t) 0;
+        });
+    });
+
+    printLatencyResults(size, chains, steps, threadCount, options);
+}
+
+// R holds the keys 1..rows in random order, the payload of a tuple is its row
+template <class T>
+static void generateInner(Tuple<T> *inner, size_t rows, size_t begin, size_t end, uint64_t seed) {
+    FeistelPermutation keys(rows, seed, JOIN_KEY_STREAM);
+    for (size_t j = begin; j < end; j++) inner[j] = Tuple<T>{(T) (keys(j) + 1), (T) j};
+}
+
+/*
+ * S draws its keys from those of R following the distribution, so every tuple finds one partner and Zipf skews the
+ * partitions. With a selectivity target the non-qualifying tuples get negative keys, which R does not hold.
+ */
+template <class T>
+static void generateOuter(Tuple<T> *outer, size_t rows, size_t innerRows, size_t begin, size_t end,
+                          const ScanOptions &options) {
+    IndexGenerator indexes(options.generator, rows, innerRows);
+    RowSelection selection(rows, max(0.0, options.selectivity), options.generator);
+    for (size_t j = begin; j < end; j++) {
+        auto generator = indexes.generator(j, 0);
+        T key = (T) (indexes.index(j, generator) + 1);
+        if (options.selectivity >= 0 && !selection.qualifies(j)) {
+            key = (T) -(int64_t) (1 + j % numeric_limits<T>::max());
+        }
+        outer[j] = Tuple<T>{key, (T) j};
+    }
+}
+
+// Where the partitions of a radix pass start, and where thread *threadId* writes its tuples of each of them
+static void partitionOffsets(const vector<vector<size_t>> &histograms, int threadId, vector<size_t> &starts,
+                             vector<size_t> &offsets) {
+    size_t fanout = histograms[0].size();
+    starts.assign(fanout + 1, 0);
+    offsets.assign(fanout, 0);
+    for (size_t p = 0; p < fanout; p++) {
+        size_t tuples = 0;
+        for (size_t t = 0; t < histograms.size(); t++) {
+            if ((int) t == threadId) offsets[p] = starts[p] + tuples;
+            tuples += histograms[t][p];
+        }
+        starts[p + 1] = starts[p] + tuples;
+    }
+}
+
+// One line per phase and sample, followed by the whole join
+static void printJoinResults(size_t size, const string &dataType, JoinAlgorithm algorithm,
+                             const vector<string> &phases, const vector<size_t> &phaseRows, unsigned radixBits,
+                             int passes, size_t innerRows, size_t outerRows, int threadCount,
+                             const ScanOptions &options) {
+    auto totalTimes = averageSampleTimes();
+    vector<vector<double>> phaseTimes(phases.size(), vector<double>(totalTimes.size(), 0));
+    for (auto &thread: threadPhaseTimes) {
+        for (size_t s = 0; s < totalTimes.size(); s++) {
+            for (size_t p = 0; p < phases.size(); p++) {
+                phaseTimes[p][s] += thread[s * phases.size() + p] / threadCount;
+            }
+        }
+    }
+    phaseTimes.push_back(totalTimes);
+    auto names = phases;
+    names.push_back("total");
+    auto rows = phaseRows;
+    rows.push_back(innerRows + outerRows);
+
+    auto matches = accumulate(threadMatches.begin(), threadMatches.end(), (uint64_t) 0);
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < totalTimes.size(); s++) {
+        for (size_t p = 0; p < names.size(); p++) {
+            auto summary = summarize(phaseTimes[p]);
+            double seconds = max(phaseTimes[p][s], 1.0) / 1e9;
+            // the counters cover the whole join
+            auto counters = sampleCounters(s);
+            if (p + 1 < names.size()) counters.assign(counters.size(), NAN);
+            if (outputFormat == OutputFormat::Json) {
+                // the phases with the time every thread spent in them, the total with the thread times
+                auto threadNanos = sampleThreadTimes(s);
+                if (p < phases.size()) {
+                    for (int j = 0; j < threadCount; j++) {
+                        threadNanos[j] = llround(threadPhaseTimes[j][s * phases.size() + p]);
+                    }
+                }
+                auto record = sampleRecord(size, s, threadNanos, options);
+                record.field("data_type", dataType).field("join", joinAlgorithmName(algorithm))
+                      .field("phase", names[p]).field("radix_bits", radixBits).field("passes", passes)
+                      .field("inner_rows", innerRows).field("outer_rows", outerRows).field("rows", rows[p])
+                      .field("time_ns", phaseTimes[p][s]).field("tuples_per_second", rows[p] / seconds)
+                      .field("selectivity", (double) matches / outerRows);
+                addCounters(record, counters);
+                cout << record.str() << endl;
+                continue;
+            }
+            cout << (size / 1024.0f) << "," << dataType << "," << threadCount << " threads,"
+                 << joinAlgorithmName(algorithm) << "," << names[p] << "," << llround(phaseTimes[p][s]) << ","
+                 << rows[p] << "," << rows[p] / seconds << "," << (double) matches / outerRows << "," << radixBits
+                 << "," << passes << "," << outerRows << "," << placement << ","
+                 << distributionName(options.generator.distribution) << "," << summaryColumns(summary);
+            printCounters(counters);
+            cout << endl;
+        }
+    }
+}
+
+/*
+ * Joins an R of *size* bytes with an S of --outer-ratio times as many tuples. An iteration is a whole join, every
+ * thread builds from and probes with its part of R and S. The phases are separated by barriers, their times do not
+ * include waiting for the other threads, the total does.
+ */
+template <class T>
+static void benchmarkJoin(JoinAlgorithm algorithm, size_t size, int threadCount, const SamplingOptions &sampling,
+                          const ScanOptions &options, const JoinOptions &join) {
+    typedef chrono::high_resolution_clock Clock;
+    const size_t innerRows = max<size_t>(1, size / sizeof(Tuple<T>));
+    const size_t outerRows = max<size_t>(1, (size_t) llround(innerRows * join.outerRatio));
+    auto innerBounds = partitionBounds(innerRows, threadCount, 1);
+    auto outerBounds = partitionBounds(outerRows, threadCount, 1);
+
+    ColumnBuffer<Tuple<T>> inner(innerRows, options.pages), outer(outerRows, options.pages);
+    placeTable(inner.data(), inner.sizeInBytes(), options);
+    placeTable(outer.data(), outer.sizeInBytes(), options);
+    workerPool->run([&](int j) {
+        generateInner(inner.data(), innerRows, innerBounds[j], innerBounds[j + 1], options.generator.seed);
+        generateOuter(outer.data(), outerRows, innerRows, outerBounds[j], outerBounds[j + 1], options);
+    });
+
+    auto dataType = "int" + to_string(sizeof(T) * 8);
+    if (algorithm == JoinAlgorithm::NoPartitioning) {
+        SharedHashTable<T> table(innerRows, options.pages);
+        placeTable(table.data(), table.size() * sizeof(Tuple<T>), options);
+        // every thread empties its own cache lines of the table
+        auto slotBounds = partitionBounds(table.size(), threadCount, CACHE_LINE_BYTES / sizeof(Tuple<T>));
+        resetMeasurements(threadCount, sampling, 2);
+
+        workerPool->run([&](int j) {
+            auto &phaseNanos = threadPhaseNanos[j];
+            measureThread(j, sampling, false, [&]() {
+                // the last probes of the previous join have to be done before the table is emptied
+                workerPool->barrier();
+                auto start = Clock::now();
+                table.clear(slotBounds[j], slotBounds[j + 1]);
+                auto cleared = Clock::now();
+                workerPool->barrier();
+                auto buildStart = Clock::now();
+                for (size_t i = innerBounds[j]; i < innerBounds[j + 1]; i++) table.insert(inner[i]);
+                auto built = Clock::now();
+                workerPool->barrier();
+                auto probeStart = Clock::now();
+                uint64_t matches = 0, checksum = 0;
+                for (size_t i = outerBounds[j]; i < outerBounds[j + 1]; i++) {
+                    matches += table.probe(outer[i].key, checksum);
+                }
+                doNotOptimize(checksum);
+                phaseNanos[0] += elapsedNanos(start, cleared) + elapsedNanos(buildStart, built);
+                phaseNanos[1] += elapsedNanos(probeStart, Clock::now());
+                return matches;
+            }, []() {
+                return (uint64_t) 0;
+            });
+        });
+        printJoinResults(size, dataType, algorithm, {"build", "probe"}, {innerRows, outerRows}, 0, 0, innerRows,
+                         outerRows, threadCount, options);
+        return;
+    }
+
+    // enough bits for the target partition size, and at least one per pass
+    unsigned bits = join.radixBits;
+    if (bits == 0) bits = min(MAX_RADIX_BITS, log2Ceil(inner.sizeInBytes() / RADIX_PARTITION_BYTES + 1));
+    bits = max<unsigned>(bits, join.passes);
+    const unsigned firstBits = join.passes == 1 ? bits : (bits + 1) / 2, secondBits = bits - firstBits;
+    const size_t fanout = (size_t) 1 << firstBits, secondFanout = (size_t) 1 << secondBits;
+    ColumnBuffer<Tuple<T>> innerPartitions(innerRows, options.pages), outerPartitions(outerRows, options.pages);
+    ColumnBuffer<Tuple<T>> innerSecond(join.passes == 2 ? innerRows : 0, options.pages);
+    ColumnBuffer<Tuple<T>> outerSecond(join.passes == 2 ? outerRows : 0, options.pages);
+    for (auto buffer: {&innerPartitions, &outerPartitions, &innerSecond, &outerSecond}) {
+        if (buffer->size() > 0) placeTable(buffer->data(), buffer->sizeInBytes(), options);
+    }
+    vector<vector<size_t>> innerHistograms(threadCount, vector<size_t>(fanout));
+    vector<vector<size_t>> outerHistograms(threadCount, vector<size_t>(fanout));
+    resetMeasurements(threadCount, sampling, 3);
+
+    workerPool->run([&](int j) {
+        auto &phaseNanos = threadPhaseNanos[j];
+        ColumnBuffer<CombiningLine<T>> lines(max(fanout, secondFanout), options.pages);
+        vector<size_t> positions(max(fanout, secondFanout)), innerStarts, outerStarts, innerOffsets, outerOffsets;
+        vector<vector<size_t>> innerSub(1), outerSub(1);
+        vector<size_t> innerSubStarts, outerSubStarts, innerSubOffsets, outerSubOffsets;
+        BucketChains chains;
+        const size_t innerBegin = innerBounds[j], innerCount = innerBounds[j + 1] - innerBegin;
+        const size_t outerBegin = outerBounds[j], outerCount = outerBounds[j + 1] - outerBegin;
+
+        measureThread(j, sampling, false, [&]() {
+            uint64_t matches = 0, checksum = 0;
+            // joins one pair of final partitions, building and probing are timed separately
+            auto joinPartition = [&](const Tuple<T> *innerPart, size_t innerTuples, const Tuple<T> *outerPart,
+                                     size_t outerTuples) {
+                auto buildStart = Clock::now();
+                chains.build(innerPart, innerTuples, bits);
+                auto built = Clock::now();
+                matches += chains.probe(innerPart, outerPart, outerTuples, checksum);
+                phaseNanos[1] += elapsedNanos(buildStart, built);
+                phaseNanos[2] += elapsedNanos(built, Clock::now());
+            };
+
+            // the previous join has to be done with the partitions before they are overwritten
+            workerPool->barrier();
+            auto start = Clock::now();
+            fill(innerHistograms[j].begin(), innerHistograms[j].end(), 0);
+            fill(outerHistograms[j].begin(), outerHistograms[j].end(), 0);
+            radixHistogram(inner.data() + innerBegin, innerCount, 0, firstBits, innerHistograms[j].data());
+            radixHistogram(outer.data() + outerBegin, outerCount, 0, firstBits, outerHistograms[j].data());
+            auto counted = Clock::now();
+            workerPool->barrier();
+            auto scatterStart = Clock::now();
+            partitionOffsets(innerHistograms, j, innerStarts, innerOffsets);
+            partitionOffsets(outerHistograms, j, outerStarts, outerOffsets);
+            radixPartition(inner.data() + innerBegin, innerCount, 0, firstBits, innerOffsets.data(),
+                           innerPartitions.data(), lines.data(), positions.data());
+            radixPartition(outer.data() + outerBegin, outerCount, 0, firstBits, outerOffsets.data(),
+                           outerPartitions.data(), lines.data(), positions.data());
+            auto scattered = Clock::now();
+            workerPool->barrier();
+            phaseNanos[0] += elapsedNanos(start, counted) + elapsedNanos(scatterStart, scattered);
+
+            // the partitions of the first pass are handed out round robin, a thread refines and joins its own
+            for (size_t p = j; p < fanout; p += threadCount) {
+                const Tuple<T> *innerPart = innerPartitions.data() + innerStarts[p];
+                const Tuple<T> *outerPart = outerPartitions.data() + outerStarts[p];
+                size_t innerTuples = innerStarts[p + 1] - innerStarts[p];
+                size_t outerTuples = outerStarts[p + 1] - outerStarts[p];
+                if (join.passes == 1) {
+                    joinPartition(innerPart, innerTuples, outerPart, outerTuples);
+                    continue;
+                }
+                auto passStart = Clock::now();
+                innerSub[0].assign(secondFanout, 0);
+                outerSub[0].assign(secondFanout, 0);
+                radixHistogram(innerPart, innerTuples, firstBits, secondBits, innerSub[0].data());
+                radixHistogram(outerPart, outerTuples, firstBits, secondBits, outerSub[0].data());
+                partitionOffsets(innerSub, 0, innerSubStarts, innerSubOffsets);
+                partitionOffsets(outerSub, 0, outerSubStarts, outerSubOffsets);
+                // the sub-partitions take the place of their partition
+                for (size_t q = 0; q < secondFanout; q++) {
+                    innerSubOffsets[q] += innerStarts[p];
+                    outerSubOffsets[q] += outerStarts[p];
+                }
+                radixPartition(innerPart, innerTuples, firstBits, secondBits, innerSubOffsets.data(),
+                               innerSecond.data(), lines.data(), positions.data());
+                radixPartition(outerPart, outerTuples, firstBits, secondBits, outerSubOffsets.data(),
+                               outerSecond.data(), lines.data(), positions.data());
+                phaseNanos[0] += elapsedNanos(passStart, Clock::now());
+                for (size_t q = 0; q < secondFanout; q++) {
+                    joinPartition(innerSecond.data() + innerSubOffsets[q], innerSubStarts[q + 1] - innerSubStarts[q],
+                                  outerSecond.data() + outerSubOffsets[q], outerSubStarts[q + 1] - outerSubStarts[q]);
+                }
+            }
+            doNotOptimize(checksum);
+            return matches;
+        }, []() {
+            return (uint64_t) 0;
+        });
+    });
+    printJoinResults(size, dataType, algorithm, {"partition", "build", "probe"},
+                     {innerRows + outerRows, innerRows, outerRows}, bits, join.passes, innerRows, outerRows,
+                     threadCount, options);
+}
+
+// Writes positions [begin, end) of a list of distinct random rows of a column of *rows* rows
+static void generatePositions(uint32_t *positions, size_t rows, size_t begin, size_t end, uint64_t seed) {
+    FeistelPermutation order(rows, seed, POSITION_STREAM);
+    for (size_t i = begin; i < end; i++) positions[i] = (uint32_t) order(i);
+}
+
+// Median tuples per second of one access pattern and data type, per prefetch distance and size
+struct PrefetchGrid {
+    string label; // e.g. "gather int32"
+    vector<vector<double>> rates; // [distance][size]
+};
+
+static void printPrefetchResults(size_t size, const string &dataType, AccessPattern access, size_t distance,
+                                 size_t rows, size_t readBytes, int threadCount, const ScanOptions &options) {
+    auto times = averageSampleTimes();
+    auto summary = summarize(times);
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < times.size(); s++) {
+        double seconds = max(times[s], 1.0) / 1e9;
+        if (outputFormat == OutputFormat::Json) {
+            auto record = sampleRecord(size, s, sampleThreadTimes(s), options);
+            record.field("data_type", dataType).field("access", accessPatternName(access))
+                  .field("prefetch_distance", distance).field("rows", rows).field("read_bytes", readBytes)
+                  .field("time_ns", times[s]).field("tuples_per_second", rows / seconds)
+                  .field("bytes_per_second", readBytes / seconds);
+            addCounters(record, sampleCounters(s));
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << dataType << "," << threadCount << " threads,"
+             << accessPatternName(access) << "," << distance << "," << llround(times[s]) << "," << rows << ","
+             << rows / seconds << "," << readBytes / seconds << "," << placement << ","
+             << distributionName(options.generator.distribution) << "," << summaryColumns(summary);
+        printCounters(sampleCounters(s));
+        cout << endl;
+    }
+}
+
+/*
+ * Scans a column of *size* bytes, or gathers from it, once for every prefetch distance. A gather visits distinct rows
+ * of the column in random order, all of them unless the position list would take more than *size* bytes.
+ */
+template <class T>
+static void benchmarkPrefetch(AccessPattern access, size_t size, const vector<size_t> &distances, int threadCount,
+                              const SamplingOptions &sampling, bool randomInit, ScanOptions options,
+                              PrefetchGrid &grid) {
+    options.predicateColumns = 1;
+    const bool gather = access == AccessPattern::Gather;
+    const size_t rows = max<size_t>(1, size / sizeof(T));
+    const size_t visited = gather ? max<size_t>(1, min(rows, size / sizeof(uint32_t))) : rows;
+    auto rowBounds = partitionBounds(rows, threadCount, CACHE_LINE_BYTES / sizeof(T));
+    auto bounds = gather ? partitionBounds(visited, threadCount, CACHE_LINE_BYTES / sizeof(uint32_t)) : rowBounds;
+
+    auto predicate = makePredicate<T>(options.predicateType, options.inListSize);
+    ColumnBuffer<T> column(tableElements<T>(rows, 1, options), options.pages);
+    ColumnBuffer<uint32_t> positions(gather ? visited : 0, options.pages);
+    placeTable(column.data(), column.sizeInBytes(), options);
+    if (gather) placeTable(positions.data(), positions.sizeInBytes(), options);
+    workerPool->run([&](int j) {
+        generateRows<T>(column.data(), rows, 1, rowBounds[j], rowBounds[j + 1], randomInit, options, predicate);
+        if (gather) generatePositions(positions.data(), rows, bounds[j], bounds[j + 1], options.generator.seed);
+    });
+
+    auto dataType = "int" + to_string(sizeof(T) * 8);
+    grid.label = accessPatternName(access) + " " + dataType;
+    grid.rates.resize(distances.size());
+    // a gather reads a position and a value per row
+    size_t readBytes = visited * (sizeof(T) + (gather ? sizeof(uint32_t) : 0));
+    for (size_t d = 0; d < distances.size(); d++) {
+        resetMeasurements(threadCount, sampling);
+        workerPool->run([&](int j) {
+            measureThread(j, sampling, false, [&]() {
+                return gather ? gatherPrefetched(column.data(), positions.data(), bounds[j], bounds[j + 1],
+                                                 distances[d])
+                              : scanPrefetched(column.data(), bounds[j], bounds[j + 1], distances[d]);
+            }, []() {
+                return (uint64_t) 0;
+            });
+        });
+        grid.rates[d].push_back(visited / max(summarize(averageSampleTimes()).median, 1.0) * 1e9);
+        printPrefetchResults(size, dataType, access, distances[d], visited, readBytes, threadCount, options);
+    }
+}
+
+// Prefetch distances in rows and the sizes in columns, so the best distance of every size can be read off
+static void printPrefetchGrids(const vector<PrefetchGrid> &grids, const vector<size_t> &distances,
+                               const vector<size_t> &sizes) {
+    for (auto &grid: grids) {
+        cerr << grid.label << ", prefetchers " << prefetcherLabel << ": M tuples/s (median)" << endl;
+        cerr << "dist\\KiB";
+        for (size_t s = 0; s < grid.rates[0].size(); s++) cerr << "\t" << sizes[s] / 1024.0f;
+        cerr << endl;
+        for (size_t d = 0; d < distances.size(); d++) {
+            cerr << distances[d];
+            for (auto rate: grid.rates[d]) cerr << "\t" << llround(rate / 1e6);
+            cerr << endl;
+        }
+    }
+}
+
+// Reads and writes are counted separately, the bytes the kernel loads and the bytes it stores
+static void printWriteResults(size_t size, const string &dataType, WriteKind kind, size_t rows, size_t readBytes,
+                              size_t writtenBytes, int threadCount, const ScanOptions &options) {
+    auto times = averageSampleTimes();
+    auto summary = summarize(times);
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < times.size(); s++) {
+        double seconds = max(times[s], 1.0) / 1e9;
+        if (outputFormat == OutputFormat::Json) {
+            auto record = sampleRecord(size, s, sampleThreadTimes(s), options);
+            record.field("data_type", dataType).field("write", writeKindName(kind)).field("rows", rows)
+                  .field("read_bytes", readBytes).field("written_bytes", writtenBytes).field("time_ns", times[s])
+                  .field("tuples_per_second", rows / seconds).field("read_bytes_per_second", readBytes / seconds)
+                  .field("write_bytes_per_second", writtenBytes / seconds);
+            addCounters(record, sampleCounters(s));
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << dataType << "," << threadCount << " threads," << writeKindName(kind)
+             << "," << llround(times[s]) << "," << rows << "," << rows / seconds << "," << readBytes / seconds << ","
+             << writtenBytes / seconds << "," << placement << "," << summaryColumns(summary);
+        printCounters(sampleCounters(s));
+        cout << endl;
+    }
+}
+
+/*
+ * Writes to a column of *size* bytes. Updates go to distinct random rows, all of them unless the position list would
+ * take more than *size* bytes. Every thread appends its rows of the column to a delta buffer of its own, which is
+ * reserved for all of them and emptied before every run.
+ */
+template <class T>
+static void benchmarkWrite(WriteKind kind, size_t size, int threadCount, const SamplingOptions &sampling,
+                           bool randomInit, ScanOptions options) {
+    options.predicateColumns = 1;
+    const bool update = kind == WriteKind::Update;
+    const size_t rows = max<size_t>(1, size / sizeof(T));
+    const size_t written = update ? max<size_t>(1, min(rows, size / sizeof(uint32_t))) : rows;
+    // no two threads write the same cache line, or the same block dcbz zeroes
+    auto rowBounds = partitionBounds(rows, threadCount, WRITE_BLOCK_BYTES / sizeof(T));
+    auto bounds = update ? partitionBounds(written, threadCount, CACHE_LINE_BYTES / sizeof(uint32_t)) : rowBounds;
+
+    auto predicate = makePredicate<T>(options.predicateType, options.inListSize);
+    ColumnBuffer<T> column(tableElements<T>(rows, 1, options), options.pages);
+    ColumnBuffer<uint32_t> positions(update ? written : 0, options.pages);
+    placeTable(column.data(), column.sizeInBytes(), options);
+    if (update) placeTable(positions.data(), positions.sizeInBytes(), options);
+    workerPool->run([&](int j) {
+        generateRows<T>(column.data(), rows, 1, rowBounds[j], rowBounds[j + 1], randomInit, options, predicate);
+        if (update) generatePositions(positions.data(), rows, bounds[j], bounds[j + 1], options.generator.seed);
+    });
+    resetMeasurements(threadCount, sampling);
+
+    workerPool->run([&](int j) {
+        // reserved and touched here, so that appends neither allocate nor fault
+        size_t reserved = kind == WriteKind::Append ? bounds[j + 1] - bounds[j] : 0;
+        ColumnBuffer<T> deltaValues(reserved, options.pages);
+        ColumnBuffer<uint32_t> deltaRows(reserved, options.pages);
+        if (reserved > 0) {
+            placeTable(deltaValues.data(), deltaValues.sizeInBytes(), options);
+            placeTable(deltaRows.data(), deltaRows.sizeInBytes(), options);
+            memset(deltaValues.data(), 0, deltaValues.sizeInBytes());
+            memset(deltaRows.data(), 0, deltaRows.sizeInBytes());
+        }
+        DeltaBuffer<T> delta{deltaValues.data(), deltaRows.data(), 0, reserved};
+        T base = 0;
+        measureThread(j, sampling, false, [&]() -> uint64_t {
+            switch (kind) {
+                case WriteKind::Fill: fillColumn(column.data(), bounds[j], bounds[j + 1], base++); break;
+                case WriteKind::Stream: streamColumn(column.data(), bounds[j], bounds[j + 1], base++); break;
+                case WriteKind::Update: updateColumn(column.data(), positions.data(), bounds[j], bounds[j + 1]); break;
+                case WriteKind::Append:
+                    delta.size = 0;
+                    return appendRows(column.data(), bounds[j], bounds[j + 1], delta);
+            }
+            doNotOptimize(column.data());
+            return bounds[j + 1] - bounds[j];
+        }, []() {
+            return (uint64_t) 0;
+        });
+    });
+
+    // an update loads a position and a value and stores the value, an append loads a value and stores it with its row
+    size_t readBytes = kind == WriteKind::Update ? written * (sizeof(uint32_t) + sizeof(T))
+                     : kind == WriteKind::Append ? written * sizeof(T) : 0;
+    size_t writtenBytes = written * (sizeof(T) + (kind == WriteKind::Append ? sizeof(uint32_t) : 0));
+    printWriteResults(size, "int" + to_string(sizeof(T) * 8), kind, written, readBytes, writtenBytes, threadCount,
+                      options);
+}
+
+/*
+ * Scans a column of *size* bytes while the last *writers* threads add 1 to random rows of it. The other threads scan
+ * their partitions like benchmark<T>. The k-th run of a writer lasts until every scanner finished its k-th scan, so
+ * the writers keep writing exactly as long as the scans run. The counters are summed over scanners and writers.
+ */
+template <class T>
+static void benchmarkMixed(size_t size, int threadCount, int writers, WriterStores stores,
+                           const SamplingOptions &sampling, bool randomInit, ScanOptions options) {
+    options.predicateColumns = 1;
+    options.outputMode = OutputMode::Count;
+    const int scanners = threadCount - writers;
+    const size_t rows = max<size_t>(1, size / sizeof(T));
+    auto bounds = partitionBounds(rows, scanners, CACHE_LINE_BYTES / sizeof(T));
+
+    auto predicate = makePredicate<T>(options.predicateType, options.inListSize);
+    ColumnBuffer<T> column(tableElements<T>(rows, 1, options), options.pages);
+    placeTable(column.data(), column.sizeInBytes(), options);
+    workerPool->run([&](int j) {
+        if (j < scanners) {
+            generateRows<T>(column.data(), rows, 1, bounds[j], bounds[j + 1], randomInit, options, predicate);
+        }
+    });
+    resetMeasurements(threadCount, sampling);
+
+    atomic<uint64_t> scansDone(0);
+    workerPool->run([&](int j) {
+        if (j < scanners) {
+            const T *columns[] = {column.data()};
+            measureThread(j, sampling, false, [&]() {
+                auto count = countMatches<T>(options.kernel, options.branchMode, columns, 1, 1, bounds[j],
+                                             bounds[j + 1], predicate);
+                scansDone.fetch_add(1, memory_order_relaxed);
+                return count;
+            }, []() {
+                return (uint64_t) 0;
+            });
+            return;
+        }
+        CounterRng generator(options.generator.seed, WRITER_STREAM, j);
+        uint64_t runs = 0;
+        measureThread(j, sampling, false, [&]() {
+            uint64_t target = ++runs * scanners;
+            auto stop = [&]() { return scansDone.load(memory_order_relaxed) >= target; };
+            return stores == WriterStores::Atomic
+                   ? updateRandomRows<WriterStores::Atomic>(column.data(), rows, generator, stop)
+                   : updateRandomRows<WriterStores::Plain>(column.data(), rows, generator, stop);
+        }, []() {
+            return (uint64_t) 0;
+        });
+    });
+
+    vector<double> scanTimes(threadTimes[0].size(), 0), writerOps(scanTimes.size(), 0);
+    for (size_t s = 0; s < scanTimes.size(); s++) {
+        for (int j = 0; j < scanners; j++) scanTimes[s] += (double) threadTimes[j][s] / scanners;
+        for (int j = scanners; j < threadCount; j++) {
+            writerOps[s] += (double) threadSampleMatches[j][s] / max(threadTimes[j][s], 1ll) * 1e9;
+        }
+    }
+    auto summary = summarize(scanTimes);
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < scanTimes.size(); s++) {
+        double seconds = max(scanTimes[s], 1.0) / 1e9;
+        if (outputFormat == OutputFormat::Json) {
+            // the thread times of the writers are the time they updated
+            auto record = sampleRecord(size, s, sampleThreadTimes(s), options);
+            record.field("data_type", "int" + to_string(sizeof(T) * 8)).field("writers", writers)
+                  .field("writer_stores", writerStoresName(stores)).field("kernel", scanKernelName(options.kernel))
+                  .field("rows", rows).field("time_ns", scanTimes[s]).field("tuples_per_second", rows / seconds)
+                  .field("bytes_per_second", rows * sizeof(T) / seconds)
+                  .field("writer_updates_per_second", writerOps[s]);
+            addCounters(record, sampleCounters(s));
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << "int" << sizeof(T) * 8 << "," << threadCount << " threads," << writers
+             << "," << writerStoresName(stores) << "," << scanKernelName(options.kernel) << ","
+             << llround(scanTimes[s]) << "," << rows << "," << rows / seconds << "," << rows * sizeof(T) / seconds
+             << "," << writerOps[s] << "," << placement << "," << summaryColumns(summary);
+        printCounters(sampleCounters(s));
+        cout << endl;
+    }
+}
+
+// Time to the first result is that of the thread that had one first
+static void printFileResults(size_t size, const string &dataType, FileAccess access, PageCache pageCache, size_t rows,
+                             size_t bytes, int threadCount, const ScanOptions &options) {
+    auto times = averageSampleTimes();
+    auto summary = summarize(times);
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < times.size(); s++) {
+        double seconds = max(times[s], 1.0) / 1e9;
+        double firstResult = threadPhaseTimes[0][s];
+        for (auto &thread: threadPhaseTimes) firstResult = min(firstResult, thread[s]);
+        if (outputFormat == OutputFormat::Json) {
+            auto record = sampleRecord(size, s, sampleThreadTimes(s), options);
+            record.field("data_type", dataType).field("file_access", fileAccessName(access))
+                  .field("page_cache", pageCacheName(pageCache)).field("rows", rows).field("time_ns", times[s])
+                  .field("first_result_ns", firstResult).field("tuples_per_second", rows / seconds)
+                  .field("bytes_per_second", bytes / seconds);
+            addCounters(record, sampleCounters(s));
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << dataType << "," << threadCount << " threads," << fileAccessName(access)
+             << "," << pageCacheName(pageCache) << "," << llround(times[s]) << "," << llround(firstResult) << ","
+             << rows << "," << rows / seconds << "," << bytes / seconds << "," << placement << ","
+             << distributionName(options.generator.distribution) << "," << summaryColumns(summary);
+        printCounters(sampleCounters(s));
+        cout << endl;
+    }
+}
+
+// Everything the data of a column file depends on, so a file is only reused for the same data
+template <class T>
+static string columnFileKey(size_t rows, bool randomInit, const ScanOptions &options) {
+    auto &generator = options.generator;
+    return "int" + to_string(sizeof(T) * 8) + " rows " + to_string(rows) + " random " + to_string(randomInit) +
+           " distribution " + distributionName(generator.distribution) + " seed " + to_string(generator.seed) +
+           " zipf " + to_string(generator.zipfExponent) + " run " + to_string(generator.runLength) +
+           " cardinality " + to_string(generator.cardinality) + " selectivity " + to_string(options.selectivity) +
+           " predicate " + predicateTypeName(options.predicateType) + " in " + to_string(options.inListSize);
+}
+
+/*
+ * Scans a column of *size* bytes in a file of *directory*, which is generated the first time and reused afterwards.
+ * Every pass maps or reads the part of each thread anew, so its time includes the page faults or reads, and the time
+ * to the first result is that of the first FILE_CHUNK_BYTES. With *prepareOnly* the file is only written.
+ */
+template <class T>
+static void benchmarkFile(const vector<FileAccess> &accesses, const vector<PageCache> &pageCaches, size_t size,
+                          const string &directory, bool prepareOnly, int threadCount, const SamplingOptions &sampling,
+                          bool randomInit, ScanOptions options) {
+    options.predicateColumns = 1;
+    const size_t rows = max<size_t>(1, size / sizeof(T));
+    // the parts of the threads start at a multiple of any page size
+    auto bounds = partitionBounds(rows, threadCount, COLUMN_FILE_HEADER_BYTES / sizeof(T));
+    auto predicate = makePredicate<T>(options.predicateType, options.inListSize);
+
+    auto key = columnFileKey<T>(rows, randomInit, options);
+    char name[64];
+    snprintf(name, sizeof(name), "/int%zu-%zu-%016llx.col", sizeof(T) * 8, rows, (unsigned long long) fnv1a(key));
+    ColumnFile file(directory + name, key, rows * sizeof(T));
+    if (!file.ok()) {
+        cerr << file.error() << endl;
+        exit(1);
+    }
+    if (file.created()) {
+        cerr << "writing " << directory + name << endl;
+        auto data = file.mapForWriting();
+        if (data == nullptr) {
+            cerr << "cannot map " << directory + name << endl;
+            exit(1);
+        }
+        workerPool->run([&](int j) {
+            generateRows<T>(reinterpret_cast<T *>(data), rows, 1, bounds[j], bounds[j + 1], randomInit, options,
+                            predicate);
+        });
+        if (!file.finish(data)) {
+            cerr << "cannot write " << directory + name << endl;
+            exit(1);
+        }
+    }
+    if (prepareOnly) return;
+
+    const size_t chunkRows = FILE_CHUNK_BYTES / sizeof(T);
+    for (auto pageCache: pageCaches) {
+        for (auto access: accesses) {
+            resetMeasurements(threadCount, sampling, 1);
+            if (pageCache == PageCache::Cold) {
+                passPreparation = [&](int j) {
+                    dropColumnPart(file.descriptor(), bounds[j] * sizeof(T), (bounds[j + 1] - bounds[j]) * sizeof(T));
+                };
+            }
+            workerPool->run([&](int j) {
+                const size_t partRows = bounds[j + 1] - bounds[j], partBytes = partRows * sizeof(T);
+                unique_ptr<ChunkReader> reader;
+                ColumnBuffer<T> buffers[2];
+                if (access == FileAccess::Pread) {
+                    reader.reset(new ChunkReader(file.descriptor()));
+                    for (auto &buffer: buffers) {
+                        buffer = ColumnBuffer<T>(chunkRows, options.pages);
+                        placeTable(buffer.data(), buffer.sizeInBytes(), options);
+                    }
+                }
+                auto count = [&](const T *column, size_t begin, size_t end) {
+                    const T *columns[] = {column};
+                    return countMatches<T>(options.kernel, options.branchMode, columns, 1, 1, begin, end, predicate);
+                };
+                measureThread(j, sampling, false, [&]() -> uint64_t {
+                    if (partRows == 0) return 0;
+                    auto start = chrono::high_resolution_clock::now();
+                    uint64_t matches = 0;
+                    if (access == FileAccess::Pread) {
+                        // a chunk is scanned while the reader fills the other buffer
+                        size_t chunks = (partRows + chunkRows - 1) / chunkRows;
+                        auto chunkEnd = [&](size_t c) { return min(partRows, (c + 1) * chunkRows); };
+                        auto read = [&](size_t c) {
+                            reader->start(reinterpret_cast<char *>(buffers[c % 2].data()),
+                                          (chunkEnd(c) - c * chunkRows) * sizeof(T),
+                                          (bounds[j] + c * chunkRows) * sizeof(T));
+                        };
+                        read(0);
+                        for (size_t c = 0; c < chunks; c++) {
+                            if (!reader->wait()) {
+                                cerr << "cannot read the column file" << endl;
+                                exit(1);
+                            }
+                            if (c + 1 < chunks) read(c + 1);
+                            matches += count(buffers[c % 2].data(), 0, chunkEnd(c) - c * chunkRows);
+                            if (c == 0) {
+                                threadPhaseNanos[j][0] += elapsedNanos(start, chrono::high_resolution_clock::now());
+                            }
+                        }
+                        return matches;
+                    }
+                    auto data = mapColumnPart(file.descriptor(), bounds[j] * sizeof(T), partBytes, access);
+                    if (data == nullptr) {
+                        cerr << "cannot map the column file" << endl;
+                        exit(1);
+                    }
+                    auto column = reinterpret_cast<const T *>(data);
+                    size_t first = min(partRows, chunkRows);
+                    matches += count(column, 0, first);
+                    threadPhaseNanos[j][0] += elapsedNanos(start, chrono::high_resolution_clock::now());
+                    matches += count(column, first, partRows);
+                    munmap(const_cast<char *>(data), partBytes);
+                    return matches;
+                }, []() {
+                    return (uint64_t) 0;
+                });
+            });
+            printFileResults(size, "int" + to_string(sizeof(T) * 8), access, pageCache, rows, rows * sizeof(T),
+                             threadCount, options);
+        }
+    }
+}
+
+// Lookups of all threads per second, and the time a thread takes per lookup, which interleaving brings down
+static void printLookupResults(size_t size, const string &dataType, LookupIndex index, Interleaving interleaving,
+                               int width, size_t lookups, size_t indexBytes, int threadCount,
+                               const ScanOptions &options) {
+    auto times = averageSampleTimes();
+    auto summary = summarize(times);
+    auto placement = placementColumns(options);
+    for (size_t s = 0; s < times.size(); s++) {
+        double seconds = max(times[s], 1.0) / 1e9;
+        double lookupNanos = times[s] * threadCount / lookups;
+        if (outputFormat == OutputFormat::Json) {
+            auto record = sampleRecord(size, s, sampleThreadTimes(s), options);
+            record.field("data_type", dataType).field("index", lookupIndexName(index))
+                  .field("interleaving", interleavingName(interleaving)).field("width", width)
+                  .field("lookups", lookups).field("index_bytes", indexBytes).field("time_ns", times[s])
+                  .field("lookups_per_second", lookups / seconds).field("time_per_lookup_ns", lookupNanos);
+            addCounters(record, sampleCounters(s));
+            cout << record.str() << endl;
+            continue;
+        }
+        cout << (size / 1024.0f) << "," << dataType << "," << threadCount << " threads," << lookupIndexName(index)
+             << "," << interleavingName(interleaving) << "," << width << "," << llround(times[s]) << "," << lookups
+             << "," << lookups / seconds << "," << lookupNanos << "," << indexBytes << "," << placement << ","
+             << summaryColumns(summary);
+        printCounters(sampleCounters(s));
+        cout << endl;
+    }
+}
+
+/*
+ * Looks up at most *lookups* distinct keys in random order in an index of *size* bytes: a sorted column, or a hash
+ * table of half as many tuples as it has slots. Every interleaving but naive runs with every width.
+ */
+template <class T>
+static void benchmarkLookup(LookupIndex indexType, const vector<Interleaving> &interleavings,
+                            const vector<int> &widths, size_t size, size_t lookups, int threadCount,
+                            const SamplingOptions &sampling, const ScanOptions &options) {
+    const bool hash = indexType == LookupIndex::Hash;
+    size_t rows = max<size_t>(1, hash ? size / sizeof(Tuple<T>) / 2 : size / sizeof(T));
+    if (rows > maxLookupRows<T>()) {
+        rows = maxLookupRows<T>();
+        cerr << "an index of int" << sizeof(T) * 8 << " keys holds at most " << rows << " rows" << endl;
+    }
+    lookups = max<size_t>(1, min(lookups, rows));
+    auto rowBounds = partitionBounds(rows, threadCount, CACHE_LINE_BYTES / sizeof(T));
+    auto bounds = partitionBounds(lookups, threadCount, 1);
+
+    ColumnBuffer<T> column(hash ? 0 : rows, options.pages);
+    unique_ptr<SharedHashTable<T>> table;
+    ColumnBuffer<T> keys(lookups, options.pages);
+    size_t indexBytes = column.sizeInBytes();
+    if (hash) {
+        table.reset(new SharedHashTable<T>(rows, options.pages));
+        indexBytes = table->size() * sizeof(Tuple<T>);
+        placeTable(table->data(), indexBytes, options);
+        auto slotBounds = partitionBounds(table->size(), threadCount, CACHE_LINE_BYTES / sizeof(Tuple<T>));
+        workerPool->run([&](int j) {
+            table->clear(slotBounds[j], slotBounds[j + 1]);
+        });
+    } else {
+        placeTable(column.data(), indexBytes, options);
+    }
+    placeTable(keys.data(), keys.sizeInBytes(), options);
+    FeistelPermutation order(rows, options.generator.seed, LOOKUP_STREAM);
+    workerPool->run([&](int j) {
+        for (size_t i = rowBounds[j]; i < rowBounds[j + 1]; i++) {
+            if (hash) table->insert({lookupKey<T>(i), (T) i});
+            else column[i] = lookupKey<T>(i);
+        }
+        for (size_t i = bounds[j]; i < bounds[j + 1]; i++) keys[i] = lookupKey<T>(order(i));
+    });
+
+    auto dataType = "int" + to_string(sizeof(T) * 8);
+    auto measure = [&](const auto &index, Interleaving interleaving, int width) {
+        resetMeasurements(threadCount, sampling);
+        workerPool->run([&](int j) {
+            measureThread(j, sampling, false, [&]() {
+                return lookupKeys(interleaving, index, keys.data(), bounds[j], bounds[j + 1], width);
+            }, []() {
+                return (uint64_t) 0;
+            });
+        });
+        auto found = accumulate(threadMatches.begin(), threadMatches.end(), (uint64_t) 0);
+        if (found != lookups) cerr << "found " << found << " of " << lookups << " keys" << endl;
+        printLookupResults(size, dataType, indexType, interleaving, width, lookups, indexBytes, threadCount, options);
+    };
+    for (auto interleaving: interleavings) {
+        // the width makes no difference to one lookup at a time
+        for (auto width: interleaving == Interleaving::Naive ? vector<int>{1} : widths) {
+            if (hash) measure(HashIndex<T>(*table), interleaving, width);
+            else measure(BinaryIndex<T>(column.data(), rows), interleaving, width);
+        }
+    }
+}
+
+// Bytes per second of all threads in the fastest sample of the last measurement, in which every thread moved *bytes*
+static double peakBandwidth(size_t bytes, int threadCount) {
+    auto times = averageSampleTimes();
+    double fastest = max(1.0, *min_element(times.begin(), times.end()));
+    return bytes * (double) threadCount / (fastest / 1e9);
+}
+
+// Runs a StreamKernel on *bytes* of arrays per thread, allocated and first touched by the thread
+static double streamBandwidth(StreamKernel kernel, size_t bytes, int threadCount, const SamplingOptions &sampling) {
+    size_t n = max<size_t>(8, bytes / streamBytes(kernel));
+    int arrays = streamArrays(kernel);
+    resetMeasurements(threadCount, sampling);
+    workerPool->run([&](int j) {
+        ColumnBuffer<uint64_t> a(n), b(arrays > 1 ? n : 0), c(arrays > 2 ? n : 0);
+        streamWrite(a.data(), n, 1);
+        if (arrays > 1) streamWrite(b.data(), n, 2);
+        if (arrays > 2) streamWrite(c.data(), n, 3);
+        measureThread(j, sampling, false, [&]() -> uint64_t {
+            switch (kernel) {
+                case StreamKernel::Read: return streamRead(a.data(), n);
+                case StreamKernel::Write: streamWrite(a.data(), n, 4); break;
+                case StreamKernel::Copy: streamCopy(a.data(), b.data(), n); break;
+                case StreamKernel::Triad: streamTriad(a.data(), b.data(), c.data(), n, 3); break;
+            }
+            doNotOptimize(a.data());
+            return 0;
+        }, []() {
+            return (uint64_t) 0;
+        });
+    });
+    return peakBandwidth(n * streamBytes(kernel), threadCount);
+}
+
+// Scans *bytes* of zeros per thread for = 0 with *kernel*, in bytes of values per second
+template <class T>
+static double compareBandwidth(ScanKernel kernel, size_t bytes, int threadCount, const SamplingOptions &sampling) {
+    size_t rows = max<size_t>(64, bytes / sizeof(T));
+    auto predicate = makePredicate<T>(PredicateType::Equal, 0);
+    resetMeasurements(threadCount, sampling);
+    workerPool->run([&](int j) {
+        ColumnBuffer<T> column(rows);
+        memset(column.data(), 0, column.sizeInBytes());
+        const T *columns[] = {column.data()};
+        measureThread(j, sampling, false, [&]() {
+            return countMatches<T>(kernel, BranchMode::Predicated, columns, 1, 1, 0, rows, predicate);
+        }, []() {
+            return (uint64_t) 0;
+        });
+    });
+    return peakBandwidth(rows * sizeof(T), threadCount);
+}
+
+// Measures the roofline of the threads of the pool, with warm caches whatever the cache state of the run
+static Roofline calibrateRoofline(const vector<CacheCapacity> &caches, int threadCount,
+                                  const SamplingOptions &sampling) {
+    Roofline result;
+    size_t cacheBytes = 0;
+    for (auto &cache: caches) {
+        size_t capacity = cache.bytes * cache.instances;
+        cacheBytes += capacity;
+        result.levels.push_back({"L" + to_string(cache.level), capacity, {}});
+    }
+    result.levels.push_back({"DRAM", numeric_limits<size_t>::max(), {}});
+    if (caches.empty()) cacheBytes = DEFAULT_LLC_BYTES;
+
+    auto runState = cacheState;
+    cacheState = CacheState::Warm;
+    for (size_t l = 0; l < result.levels.size(); l++) {
+        // working sets as described in roofline.h
+        auto &level = result.levels[l];
+        size_t bytes = l + 1 == result.levels.size() ? 4 * cacheBytes
+                     : l > 0 ? min(level.capacity / 2, 2 * result.levels[l - 1].capacity) : level.capacity / 2;
+        for (auto kernel: STREAM_KERNELS) {
+            level.bandwidth[(int) kernel] = streamBandwidth(kernel, bytes / threadCount, threadCount, sampling);
+        }
+    }
+    // the first level if sysfs describes it, else a size that fits any first level cache
+    size_t l1Bytes = caches.empty() ? 16 * KiB : result.levels[0].capacity / 2 / threadCount;
+    auto kernel = resolveScanKernel(ScanKernel::Auto);
+    result.compareKernel = scanKernelName(kernel);
+    result.compareBytes[0] = compareBandwidth<int8_t>(kernel, l1Bytes, threadCount, sampling);
+    result.compareBytes[1] = compareBandwidth<int16_t>(kernel, l1Bytes, threadCount, sampling);
+    result.compareBytes[2] = compareBandwidth<int32_t>(kernel, l1Bytes, threadCount, sampling);
+    result.compareBytes[3] = compareBandwidth<int64_t>(kernel, l1Bytes, threadCount, sampling);
+    cacheState = runState;
+    return result;
+}
+
+// Calibrates the roofline of the run, prints it to stderr and adds it to the metadata of the JSON records
+static void measureRoofline(const vector<CacheCapacity> &caches, int threadCount, const SamplingOptions &sampling) {
+    cerr << "measuring the roofline" << endl;
+    roofline = calibrateRoofline(caches, threadCount, sampling);
+    runMetadata.rooflineLevels.clear();
+    runMetadata.rooflineRead.clear();
+    runMetadata.rooflineWrite.clear();
+    runMetadata.rooflineCopy.clear();
+    runMetadata.rooflineTriad.clear();
+    for (auto &level: roofline.levels) {
+        cerr << level.name << ":";
+        for (auto kernel: STREAM_KERNELS) {
+            cerr << " " << streamKernelName(kernel) << " " << level.bandwidth[(int) kernel] / 1e9 << " GB/s";
+        }
+        cerr << endl;
+        runMetadata.rooflineLevels.push_back(level.name);
+        runMetadata.rooflineRead.push_back(level.bandwidth[(int) StreamKernel::Read]);
+        runMetadata.rooflineWrite.push_back(level.bandwidth[(int) StreamKernel::Write]);
+        runMetadata.rooflineCopy.push_back(level.bandwidth[(int) StreamKernel::Copy]);
+        runMetadata.rooflineTriad.push_back(level.bandwidth[(int) StreamKernel::Triad]);
+    }
+    cerr << "compare (" << roofline.compareKernel << "):";
+    for (int type = 0; type < 4; type++) {
+        cerr << " int" << (8 << type) << " " << roofline.compareBytes[type] / 1e9 << " GB/s";
+    }
+    cerr << endl;
+    runMetadata.compareKernel = roofline.compareKernel;
+    runMetadata.compareBandwidth.assign(roofline.compareBytes, roofline.compareBytes + 4);
 }
 
 int main(int argc, char* argv[]) {
     int colCount; // = 1 --> column-based layout, > 1 --> row-based layout
     int threadCount;
-    int iterations;
-    int sampleSize;
+    SamplingOptions sampling;
     bool randomInit;
     bool help;
 
     string dataTypes;
+    string kernelName;
+    string predicateName;
+    string branchingName;
+    string outputName;
+    string bitWidths;
+    string packingName;
+    string counterNames;
+    string cpuList;
+    string placementName;
+    bool numaMatrix;
+    string pagesName;
+    string modeName;
+    string chainCounts;
+    string layoutNames;
+    string schemaWidths;
+    string attributeCountList;
+    size_t groupRows;
+    string distributionName;
+    string aggregateName;
+    string joinNames;
+    JoinOptions join;
+    string accessNames;
+    string prefetcherList;
+    string writeNames;
+    int writers;
+    string writerStoresName;
+    string distanceList;
+    string formatName;
+    string columnDirectory;
+    string fileAccessNames;
+    string pageCacheNames;
+    bool prepareFiles;
+    string minSizeText;
+    string maxSizeText;
+    SweepOptions sweep;
+    string cacheStateName;
+    bool rooflineCalibration;
+    string indexNames;
+    string interleavingNames;
+    string widthList;
+    size_t lookupCount;
+    ScanOptions options;
     Flags flags;
+    flags.Var(modeName, 'm', "mode", string("scan"),
+              "Benchmark: scan (bandwidth), latency (dependent loads through a random cycle over each size), table "
+              "(scans of k attributes of a mixed-width table, see Table), join (hash joins of an inner relation of "
+              "each size, see Join), prefetch (scans and gathers with software prefetching, see Prefetch), "
+              "write (fills, updates and appends, see Write), mixed (scans under concurrent writers, see Mixed), "
+              "file (scans of columns in files, see File) or lookup (interleaved index lookups, see Lookup)");
     flags.Var(colCount, 'c', "column-count", 1, "Number of columns to use");
     flags.Var(threadCount, 't', "thread-count", 1, "Number of threads");
-    flags.Var(iterations, 'i', "iterations", 0, "Number of inner iterations");
-    flags.Var(sampleSize, 's', "sample-size", 10, "Number of measurements");
+    flags.Var(cpuList, 0, "cpus", string(""),
+              "CPUs to pin the threads to in order, e.g. 0-14,120-134 (default: all CPUs the process may use)");
+    flags.Var(sampling.iterations, 'i', "iterations", 0,
+              "Number of inner iterations (0: calibrated to take --min-sample-time)");
+    flags.Var(sampling.sampleSize, 's', "sample-size", 10, "Number of measurements, the minimum with --rel-error");
+    flags.Var(sampling.minSampleTime, 0, "min-sample-time", 0.001, "Seconds a calibrated sample takes at least",
+              "Sampling");
+    flags.Var(cacheStateName, 0, "cache-state", string("warm"),
+              "Caches every sample starts with: warm (iterations back to back), cold (working set flushed from all "
+              "caches) or llc-only (working set in the last level cache only); cold and llc-only time single runs "
+              "and take no --iterations",
+              "Sampling");
+    flags.Var(sampling.warmupSamples, 0, "warmup", 1, "Samples taken first and dropped", "Sampling");
+    flags.Var(sampling.relError, 0, "rel-error", 0.0,
+              "Sample until the 95% confidence interval of the median is within this fraction of it (0: off)",
+              "Sampling");
+    flags.Var(sampling.timeBudget, 0, "time-budget", 10.0, "Seconds of sampling per table at most with --rel-error",
+              "Sampling");
     flags.Var(dataTypes, 'd', "data-types", string(""), "Comma-separated list of types (e.g. 8 for int8_t)");
+    flags.Var(kernelName, 'k', "kernel", string("scalar"), "Scan kernel: scalar, sse, avx2, avx512, vsx or auto");
+    flags.Var(predicateName, 'p', "predicate", string("equal"), "Predicate: equal (= 0), between (0 and 100) or in",
+              "Predicate");
+    flags.Var(options.inListSize, 0, "in-list-size", (size_t) 4, "Number of values in the IN-list (0, 2, 4, ...)",
+              "Predicate");
+    flags.Var(options.predicateColumns, 0, "predicate-columns", 1,
+              "Number of columns the predicate is evaluated on (conjunction)", "Predicate");
+    flags.Var(options.selectivity, 0, "selectivity", -1.0,
+              "Fraction of qualifying rows, data is generated to hit it exactly (negative: plain initialization)",
+              "Predicate");
+    flags.Var(branchingName, 'b', "branching", string("branchy"), "Scalar kernel: branchy or predicated",
+              "Predicate");
+    flags.Var(outputName, 'o', "output", string("count"),
+              "Scan result: count, bitmap, positions32, positions64 or values (compacted)", "Predicate");
+    flags.Var(bitWidths, 0, "bit-widths", string(""),
+              "Comma-separated list of code widths (1 to 32) of dictionary-encoded columns to scan, only these are "
+              "benchmarked unless --data-types is given as well", "Compression");
+    flags.Var(packingName, 0, "packing", string("vertical"),
+              "Layout of the codes: vertical (SIMD-BP128) or horizontal", "Compression");
+    flags.Var(placementName, 0, "placement", string("local"),
+              "Where the columns are placed: local (every thread touches its partition first), node (all on "
+              "--memory-node, e.g. a remote one) or interleave (over all nodes)", "NUMA");
+    flags.Var(options.memoryNode, 0, "memory-node", 0, "Memory node for --placement node", "NUMA");
+    flags.Bool(numaMatrix, 0, "numa-matrix",
+               "Run every size on every (CPU node, memory node) pair and print a bandwidth matrix to stderr", "NUMA");
+    flags.Var(chainCounts, 0, "chains", string("1,2,4,8,16"),
+              "Comma-separated numbers of chains followed at once (1 to 16), the latency in cycles needs the cycles "
+              "counter", "Latency");
+    flags.Var(layoutNames, 0, "layouts", string("nsm,dsm,pax"),
+              "Comma-separated layouts of --mode table: nsm (rows), dsm (columns) or pax (row groups)", "Table");
+    flags.Var(schemaWidths, 0, "schema", string("64,32,32,16,8,8,64,32"),
+              "Comma-separated attribute widths in bits (8, 16, 32 or 64) of --mode table", "Table");
+    flags.Var(attributeCountList, 0, "attributes", string("1,2,4,8"),
+              "Comma-separated numbers k of attributes to scan, the predicate is evaluated on the first k", "Table");
+    flags.Var(groupRows, 0, "group-rows", (size_t) 1024, "Rows per PAX row group, a multiple of 64", "Table");
+    flags.Var(aggregateName, 0, "aggregate", string("none"),
+              "Aggregate the column instead of scanning it: none, sum, min, max or avg", "Aggregate");
+    flags.Bool(options.filtered, 0, "filtered", "Aggregate only the rows that satisfy the predicate", "Aggregate");
+    flags.Var(options.groups, 0, "group-by", (size_t) 0,
+              "GROUP BY a key column with this many distinct values, drawn from --distribution (0: no grouping)",
+              "Aggregate");
+    flags.Var(joinNames, 0, "joins", string("npo,radix"),
+              "Comma-separated joins of --mode join: npo (shared hash table) or radix (partitioned)", "Join");
+    flags.Var(join.radixBits, 0, "radix-bits", 0u,
+              "Partition bits of the radix join (0: partitions of R of 64 KiB, at most 18 bits)", "Join");
+    flags.Var(join.passes, 0, "passes", 2, "Partitioning passes of the radix join, 1 or 2", "Join");
+    flags.Var(join.outerRatio, 0, "outer-ratio", 1.0, "Tuples of the probing relation S per tuple of R", "Join");
+    flags.Var(accessNames, 0, "access", string("scan,gather"),
+              "Comma-separated access patterns of --mode prefetch: scan (sequential) or gather (random positions)",
+              "Prefetch");
+    flags.Var(distanceList, 0, "prefetch-distance", string("0,1,2,4,8,16,32,64"),
+              "Comma-separated prefetch distances, in cache lines for scans and positions for gathers (0: none)",
+              "Prefetch");
+    flags.Var(writeNames, 0, "writes", string("fill,stream,update,append"),
+              "Comma-separated writes of --mode write: fill (sequential), stream (sequential, without read for "
+              "ownership), update (random rows in place) or append (into a reserved delta buffer)", "Write");
+    flags.Var(writers, 0, "writers", 1,
+              "Threads of --mode mixed that update random rows of the scanned column, the last ones of the pool",
+              "Mixed");
+    flags.Var(writerStoresName, 0, "writer-stores", string("atomic"),
+              "Updates of the writers: atomic (read-modify-write) or plain", "Mixed");
+    flags.Var(columnDirectory, 0, "column-dir", string(""),
+              "Directory of the column files of --mode file, which are written once per data type, size and data "
+              "options and reused afterwards", "File");
+    flags.Var(fileAccessNames, 0, "file-access", string("mmap,willneed,populate,pread"),
+              "Comma-separated ways to read the column files: mmap (page faults), willneed (mmap with readahead of "
+              "the whole part), populate (MAP_POPULATE) or pread (double-buffered chunks); there is no io_uring "
+              "access", "File");
+    flags.Var(pageCacheNames, 0, "page-cache", string("warm,cold"),
+              "Comma-separated page cache states of --mode file: warm, or cold (dropped before every pass)", "File");
+    flags.Bool(prepareFiles, 0, "prepare-files", "Only write the column files of --mode file", "File");
+    flags.Var(indexNames, 0, "indexes", string("binary,hash"),
+              "Comma-separated indexes of --mode lookup: binary (search of a sorted column) or hash (probes of a "
+              "linear probing table)", "Lookup");
+    flags.Var(interleavingNames, 0, "interleavings", string("naive,group,amac,coro"),
+              "Comma-separated ways to interleave the lookups: naive (one at a time), group (group prefetching), amac "
+              "(asynchronous memory access chaining) or coro (C++20 coroutines)", "Lookup");
+    flags.Var(widthList, 0, "interleave", string("2,4,8,16,32"),
+              "Comma-separated numbers of lookups in flight per thread (1 to 64)", "Lookup");
+    flags.Var(lookupCount, 0, "lookups", (size_t) 1 << 20,
+              "Distinct keys looked up per sample, at most one per row of the index", "Lookup");
+    flags.Var(prefetcherList, 0, "prefetchers", string(""),
+              "Comma-separated masks of enabled hardware prefetchers to run everything with, or all for the 16 "
+              "combinations: bit 0 L2 streamer, 1 L2 adjacent line, 2 DCU next line, 3 DCU IP (Intel, needs root and "
+              "the msr module; default: leave them as they are, restored at exit)", "Prefetchers");
+    flags.Var(options.morselRows, 0, "morsel-rows", (size_t) 0,
+              "Rows per morsel, a multiple of 64: threads take morsels from their own deque and steal from the others, "
+              "NUMA-local ones first (0: every thread scans a static partition)", "Scheduling");
+    flags.Var(formatName, 0, "format", string("csv"),
+              "Results: csv (a header and a line per sample) or json (a JSON object per line and sample with the "
+              "time of every thread and the metadata of the run: CPU model, SMT level, compiler, flags and revision)",
+              "Output");
+    flags.Var(minSizeText, 0, "min-size", string("8K"), "Smallest size of the sweep, in bytes or with K, M or G",
+              "Sizes");
+    flags.Var(maxSizeText, 0, "max-size", string("4G"), "Largest size of the sweep", "Sizes");
+    flags.Var(sweep.points, 0, "points", 20,
+              "Log-spaced sizes from --min-size to --max-size, to which the sweep adds sizes around the capacity of "
+              "every cache level the threads use, read from sysfs", "Sizes");
+    flags.Bool(rooflineCalibration, 0, "roofline",
+               "Measure the read, write, copy and triad bandwidth of every cache level and DRAM and the compare "
+               "throughput of the widest scan kernel on the threads first, and report scans as a fraction of it",
+               "Roofline");
+    flags.Var(pagesName, 0, "pages", string("default"),
+              "Pages of columns and result buffers: default, small (no THP), thp, 2m or 1g (hugetlbfs), 16m (POWER)",
+              "Memory");
+    flags.Var(counterNames, 0, "counters", string(DEFAULT_COUNTERS),
+              "Comma-separated list of hardware counters per scan: cycles, instructions, llc-misses, l1d-misses, "
+              "dtlb-misses, branch-misses, task-clock, page-faults, rHEX or name=rHEX for raw events, or none",
+              "Counters");
     flags.Bool(randomInit, 'r', "random-init", "Initialize randomly instead of 0-initialization", "Optional");
+    flags.Var(distributionName, 0, "distribution", string("uniform"),
+              "Values with -r or a selectivity target: uniform, zipf, sorted, runs or lowcard; any but uniform "
+              "implies -r. Qualifying rows are sorted first or form runs with sorted and runs", "Data");
+    flags.Var(options.generator.seed, 0, "seed", (uint64_t) 0, "Seed of the data, the same for any thread count",
+              "Data");
+    flags.Var(options.generator.zipfExponent, 0, "zipf-exponent", 1.0, "Skew of --distribution zipf", "Data");
+    flags.Var(options.generator.runLength, 0, "run-length", (uint64_t) 1024, "Rows per run of --distribution runs",
+              "Data");
+    flags.Var(options.generator.cardinality, 0, "cardinality", (uint64_t) 0,
+              "Distinct values of zipf, sorted, runs and lowcard (0: the whole domain, 16 for lowcard)", "Data");
     flags.Bool(help, 'h', "help", "Show this help and exit", "Help");
 
+    // getopt reorders argv
+    vector<string> arguments(argv, argv + argc);
     if (!flags.Parse(argc, argv)) {
         flags.PrintHelp(argv[0]);
         return 1;
@@ -187,10 +2124,340 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    bool useInt8 = true;
-    bool useInt16 = true;
-    bool useInt32 = true;
-    bool useInt64 = true;
+    if (!parseByteSize(minSizeText, sweep.minSize) || !parseByteSize(maxSizeText, sweep.maxSize) ||
+        sweep.minSize < KiB || sweep.maxSize < sweep.minSize || sweep.points < 0) {
+        cerr << "sizes go from at least 1K up to --max-size, with a non-negative number of points" << endl;
+        return 1;
+    }
+    if (!parseCacheState(cacheStateName, cacheState)) {
+        cerr << "unknown cache state " << cacheStateName << endl;
+        return 1;
+    }
+    if (cacheState != CacheState::Warm && sampling.iterations > 0) {
+        cerr << "a sample with --cache-state " << cacheStateName << " is a single run, it takes no --iterations"
+             << endl;
+        return 1;
+    }
+    if (!parseOutputFormat(formatName, outputFormat)) {
+        cerr << "unknown format " << formatName << endl;
+        return 1;
+    }
+    if (!parseScanKernel(kernelName, options.kernel)) {
+        cerr << "unknown kernel " << kernelName << endl;
+        return 1;
+    }
+    options.kernel = resolveScanKernel(options.kernel);
+    if (!scanKernelSupported(options.kernel)) {
+        cerr << "kernel " << kernelName << " is not supported on this CPU" << endl;
+        return 1;
+    }
+    if (!parsePredicateType(predicateName, options.predicateType)) {
+        cerr << "unknown predicate " << predicateName << endl;
+        return 1;
+    }
+    if (!parseBranchMode(branchingName, options.branchMode)) {
+        cerr << "unknown branching " << branchingName << endl;
+        return 1;
+    }
+    if (!parseOutputMode(outputName, options.outputMode)) {
+        cerr << "unknown output " << outputName << endl;
+        return 1;
+    }
+    if (options.selectivity > 1 || options.predicateColumns < 1 ||
+        (colCount > 1 && options.predicateColumns > colCount)) {
+        cerr << "selectivity must be at most 1 and a row store needs at least as many columns as predicate columns"
+             << endl;
+        return 1;
+    }
+
+    if (!parsePacking(packingName, options.packing)) {
+        cerr << "unknown packing " << packingName << endl;
+        return 1;
+    }
+    vector<unsigned> packedWidths;
+    if (!bitWidths.empty()) {
+        for (auto width: parseDataTypes(bitWidths)) {
+            int bitWidth = atoi(width.c_str());
+            if (bitWidth < 1 || bitWidth > 32) {
+                cerr << "bit widths must be between 1 and 32" << endl;
+                return 1;
+            }
+            packedWidths.push_back(bitWidth);
+        }
+        if (colCount > 1 || options.predicateColumns > 1 || options.outputMode == OutputMode::Values) {
+            cerr << "bit-packed columns are scanned as a single column store column and cannot output values" << endl;
+            return 1;
+        }
+    }
+
+    if (counterNames != "none") {
+        for (auto name: parseDataTypes(counterNames)) {
+            CounterEvent event;
+            if (!parseCounterEvent(name, event)) {
+                cerr << "unknown counter " << name << endl;
+                return 1;
+            }
+            counterEvents.push_back(event);
+        }
+        CounterGroup probe(counterEvents);
+        for (size_t e = 0; e < counterEvents.size(); e++) {
+            if (!probe.available(e)) cerr << "counter " << counterEvents[e].name << " is not available" << endl;
+        }
+    }
+
+    if (!parsePlacement(placementName, options.placement)) {
+        cerr << "unknown placement " << placementName << endl;
+        return 1;
+    }
+
+    if (sampling.iterations < 0 || sampling.sampleSize < 1 || sampling.warmupSamples < 0 ||
+        sampling.minSampleTime <= 0) {
+        cerr << "need at least one sample, no negative iterations or warm-up samples and a positive sample time"
+             << endl;
+        return 1;
+    }
+
+    if (!parseDistribution(distributionName, options.generator.distribution) ||
+        options.generator.zipfExponent <= 0) {
+        cerr << "unknown distribution " << distributionName << " or zipf exponent not positive" << endl;
+        return 1;
+    }
+
+    if (!parsePageMode(pagesName, options.pages)) {
+        cerr << "unknown pages " << pagesName << endl;
+        return 1;
+    }
+
+    if (!parseAggregate(aggregateName, options.aggregate)) {
+        cerr << "unknown aggregate " << aggregateName << endl;
+        return 1;
+    }
+    if (options.aggregate != Aggregate::None && (colCount > 1 || options.predicateColumns > 1 ||
+        options.outputMode != OutputMode::Count || !packedWidths.empty() || modeName != "scan")) {
+        cerr << "aggregates are scans of a single column store column with --output count" << endl;
+        return 1;
+    }
+    if (options.morselRows % 64 != 0 || (options.morselRows > 0 && (options.outputMode != OutputMode::Count ||
+        options.aggregate != Aggregate::None || !packedWidths.empty() || modeName != "scan"))) {
+        cerr << "morsels are a multiple of 64 rows, for scans of plain columns with --output count" << endl;
+        return 1;
+    }
+    if (options.groups > (1 << 16) || (options.groups > 0 && options.aggregate == Aggregate::None)) {
+        cerr << "GROUP BY needs an aggregate and at most 65536 groups" << endl;
+        return 1;
+    }
+
+    bool latencyMode = modeName == "latency";
+    bool tableMode = modeName == "table";
+    vector<Layout> layouts;
+    vector<unsigned> widths;
+    vector<int> attributeCounts;
+    if (tableMode) {
+        for (auto name: parseDataTypes(layoutNames)) {
+            layouts.emplace_back();
+            if (!parseLayout(name, layouts.back())) {
+                cerr << "unknown layout " << name << endl;
+                return 1;
+            }
+        }
+        for (auto bits: parseDataTypes(schemaWidths)) {
+            int width = atoi(bits.c_str());
+            if (width != 8 && width != 16 && width != 32 && width != 64) {
+                cerr << "attribute widths must be 8, 16, 32 or 64 bits" << endl;
+                return 1;
+            }
+            widths.push_back(width / 8);
+        }
+        for (auto count: parseDataTypes(attributeCountList)) attributeCounts.push_back(atoi(count.c_str()));
+        if (groupRows == 0 || groupRows % 64 != 0 || *min_element(attributeCounts.begin(), attributeCounts.end()) < 1) {
+            cerr << "PAX row groups need a multiple of 64 rows and at least one attribute has to be scanned" << endl;
+            return 1;
+        }
+    }
+    vector<int> chains;
+    for (auto count: parseDataTypes(chainCounts)) {
+        chains.push_back(atoi(count.c_str()));
+        if (chains.back() < 1 || chains.back() > MAX_CHAINS) {
+            cerr << "chains must be between 1 and " << MAX_CHAINS << endl;
+            return 1;
+        }
+    }
+    bool joinMode = modeName == "join";
+    vector<JoinAlgorithm> joins;
+    if (joinMode) {
+        for (auto name: parseDataTypes(joinNames)) {
+            joins.emplace_back();
+            if (!parseJoinAlgorithm(name, joins.back())) {
+                cerr << "unknown join " << name << endl;
+                return 1;
+            }
+        }
+        if (join.passes < 1 || join.passes > 2 || join.radixBits > MAX_RADIX_BITS || join.outerRatio <= 0) {
+            cerr << "radix joins take 1 or 2 passes and at most " << MAX_RADIX_BITS << " bits, S needs tuples"
+                 << endl;
+            return 1;
+        }
+    }
+    bool prefetchMode = modeName == "prefetch";
+    vector<AccessPattern> accesses;
+    vector<size_t> distances;
+    if (prefetchMode) {
+        for (auto name: parseDataTypes(accessNames)) {
+            accesses.emplace_back();
+            if (!parseAccessPattern(name, accesses.back())) {
+                cerr << "unknown access pattern " << name << endl;
+                return 1;
+            }
+        }
+        for (auto distance: parseDataTypes(distanceList)) {
+            if (distance.empty() || distance.find_first_not_of("0123456789") != string::npos) {
+                cerr << "prefetch distances must be non-negative numbers" << endl;
+                return 1;
+            }
+            distances.push_back(stoul(distance));
+        }
+    }
+    bool writeMode = modeName == "write";
+    vector<WriteKind> writes;
+    if (writeMode) {
+        for (auto name: parseDataTypes(writeNames)) {
+            writes.emplace_back();
+            if (!parseWriteKind(name, writes.back())) {
+                cerr << "unknown write " << name << endl;
+                return 1;
+            }
+        }
+    }
+    bool mixedMode = modeName == "mixed";
+    WriterStores writerStores;
+    if (mixedMode && (!parseWriterStores(writerStoresName, writerStores) || writers < 0 ||
+                      writers >= threadCount)) {
+        cerr << "writers are atomic or plain, and at least one thread has to scan" << endl;
+        return 1;
+    }
+    bool fileMode = modeName == "file";
+    vector<FileAccess> fileAccesses;
+    vector<PageCache> pageCaches;
+    if (fileMode) {
+        for (auto name: parseDataTypes(fileAccessNames)) {
+            fileAccesses.emplace_back();
+            if (!parseFileAccess(name, fileAccesses.back())) {
+                cerr << "unknown file access " << name << endl;
+                return 1;
+            }
+        }
+        for (auto name: parseDataTypes(pageCacheNames)) {
+            pageCaches.emplace_back();
+            if (!parsePageCache(name, pageCaches.back())) {
+                cerr << "unknown page cache state " << name << endl;
+                return 1;
+            }
+        }
+        if (columnDirectory.empty()) {
+            cerr << "--mode file needs a --column-dir" << endl;
+            return 1;
+        }
+    }
+    bool lookupMode = modeName == "lookup";
+    vector<LookupIndex> indexes;
+    vector<Interleaving> interleavings;
+    vector<int> interleaveWidths;
+    if (lookupMode) {
+        for (auto name: parseDataTypes(indexNames)) {
+            indexes.emplace_back();
+            if (!parseLookupIndex(name, indexes.back())) {
+                cerr << "unknown index " << name << endl;
+                return 1;
+            }
+        }
+        for (auto name: parseDataTypes(interleavingNames)) {
+            Interleaving interleaving;
+            if (!parseInterleaving(name, interleaving)) {
+                cerr << "unknown interleaving " << name << endl;
+                return 1;
+            }
+            if (interleavingSupported(interleaving)) interleavings.push_back(interleaving);
+            else cerr << "interleaving " << name << " needs a compiler with C++20 coroutines, skipped" << endl;
+        }
+        for (auto width: parseDataTypes(widthList)) {
+            interleaveWidths.push_back(atoi(width.c_str()));
+            if (interleaveWidths.back() < 1 || interleaveWidths.back() > MAX_INTERLEAVE) {
+                cerr << "interleave widths must be between 1 and " << MAX_INTERLEAVE << endl;
+                return 1;
+            }
+        }
+        if (lookupCount == 0) {
+            cerr << "need at least one lookup" << endl;
+            return 1;
+        }
+    }
+    if (!latencyMode && !tableMode && !joinMode && !prefetchMode && !writeMode && !mixedMode && !fileMode &&
+        !lookupMode && modeName != "scan") {
+        cerr << "unknown mode " << modeName << endl;
+        return 1;
+    }
+    if (numaMatrix && modeName != "scan") {
+        cerr << "the NUMA matrix is only measured for scans, not with --mode " << modeName << endl;
+        return 1;
+    }
+
+    vector<int> cpus;
+    if (threadCount < 1 || !parseCpuList(cpuList, cpus)) {
+        cerr << "need at least one thread and a valid CPU list" << endl;
+        return 1;
+    }
+    workerPool.reset(new WorkerPool(threadCount, cpus));
+    if (!workerPool->allPinned()) {
+        cerr << "not all threads could be pinned to their CPUs" << endl;
+        return 1;
+    }
+
+    vector<unsigned> prefetcherMasks;
+    unique_ptr<PrefetcherControl> prefetchers; // restores the prefetchers when main returns, exits or is killed
+    if (!prefetcherList.empty()) {
+        for (auto name: parseDataTypes(prefetcherList)) {
+            if (name == "all") {
+                for (unsigned mask = 0; mask <= ALL_PREFETCHERS; mask++) prefetcherMasks.push_back(mask);
+                continue;
+            }
+            prefetcherMasks.emplace_back();
+            if (!parsePrefetcherMask(name, prefetcherMasks.back())) {
+                cerr << "prefetcher masks go from 0x0 to 0xf" << endl;
+                return 1;
+            }
+        }
+        prefetchers.reset(new PrefetcherControl(onlineCpus(), true));
+        if (!prefetchers->ok()) {
+            cerr << "cannot control the prefetchers: " << prefetchers->error() << endl;
+            return 1;
+        }
+    } else {
+        // records which prefetchers the run had if the MSR can be read, without changing them
+        PrefetcherControl current(workerPool->cpus(), false);
+        if (current.ok()) {
+            prefetcherMask = current.masks()[0];
+            prefetcherLabel = prefetcherMaskLabel(prefetcherMask);
+        }
+    }
+    runMetadata = RunMetadata::collect(modeName, arguments, workerPool->cpus()[0]);
+
+    // latency working sets are per thread
+    auto caches = poolCacheCapacities(workerPool->cpus());
+    auto sizes = sweepSizes(sweep, caches, threadCount, latencyMode);
+    for (auto &cache: caches) {
+        cerr << "L" << cache.level << ": " << cache.instances << " x " << byteSizeLabel(cache.bytes) << ", shared by "
+             << cache.sharingCpus << " CPUs" << endl;
+        runMetadata.cacheLevels.push_back(cache.level);
+        runMetadata.cacheBytes.push_back(cache.bytes);
+        runMetadata.cacheInstances.push_back(cache.instances);
+        runMetadata.cacheSharingCpus.push_back(cache.sharingCpus);
+    }
+    if (caches.empty()) cerr << "no caches in sysfs, the sizes are log-spaced only" << endl;
+
+    bool useInt8 = packedWidths.empty();
+    bool useInt16 = packedWidths.empty();
+    bool useInt32 = packedWidths.empty();
+    bool useInt64 = packedWidths.empty();
     if (!dataTypes.empty()) {
         auto result = parseDataTypes(dataTypes);
         useInt8 = (find(result.begin(), result.end(), "8") != result.end());
@@ -198,26 +2465,254 @@ int main(int argc, char* argv[]) {
         useInt32 = (find(result.begin(), result.end(), "32") != result.end());
         useInt64 = (find(result.begin(), result.end(), "64") != result.end());
     }
+    // join keys have to be unique in R, as do the keys of an index
+    if ((joinMode || lookupMode) && !dataTypes.empty() && (useInt8 || useInt16)) {
+        cerr << "joins and lookups need 32 or 64 bit keys" << endl;
+        return 1;
+    }
+    // the narrowest values make the most rows, and a packed column has more rows than bytes
+    if (options.outputMode == OutputMode::Positions32) {
+        unsigned narrowestBits = useInt8 ? 8 : useInt16 ? 16 : useInt32 ? 32 : 64;
+        for (auto bitWidth: packedWidths) narrowestBits = min(narrowestBits, bitWidth);
+        if (sweep.maxSize / narrowestBits * 8 > ((uint64_t) 1 << 32)) {
+            cerr << "columns of --max-size " << maxSizeText << " have more than 2^32 rows, which positions32 cannot "
+                 << "number, use positions64" << endl;
+            return 1;
+        }
+    }
 
-    cout << "Column size in KB,Data type,Time in ns,Thread Count,DB type" << endl;
-    for (auto size: DB_SIZES){
-        cerr << "benchmarking " << (size / 1024.0f) << " KiB" << endl;
-
-        // For smallest size, iterations will be ITERATIONS_FACTOR. For double the size half of that etc. (but at least 6)
-        int dynamicIterations = iterations == 0 ? max(6, (int) (ITERATIONS_FACTOR / size * DB_SIZES[0])) : iterations;
-
+    if (outputFormat == OutputFormat::Json) {
+        // no header, every record names its fields
+    } else if (joinMode) {
+        cout << "Inner size in KB,Data type,Thread Count,Join,Phase,Time in ns,Rows,Tuples per second,Selectivity,"
+                "Radix bits,Passes,Outer rows," << PLACEMENT_HEADER << ",Distribution," << SUMMARY_HEADER;
+    } else if (prefetchMode) {
+        cout << "Column size in KB,Data type,Thread Count,Access,Prefetch distance,Time in ns,Rows,Tuples per second,"
+                "Bytes per second," << PLACEMENT_HEADER << ",Distribution," << SUMMARY_HEADER;
+    } else if (writeMode) {
+        cout << "Column size in KB,Data type,Thread Count,Write,Time in ns,Rows,Tuples per second,"
+                "Read bytes per second,Write bytes per second," << PLACEMENT_HEADER << "," << SUMMARY_HEADER;
+    } else if (mixedMode) {
+        cout << "Column size in KB,Data type,Thread Count,Writers,Writer stores,Kernel,Time in ns,Rows,"
+                "Tuples per second,Bytes per second,Writer updates per second," << PLACEMENT_HEADER << ","
+             << SUMMARY_HEADER;
+    } else if (fileMode) {
+        cout << "Column size in KB,Data type,Thread Count,File access,Page cache,Time in ns,"
+                "Time to first result in ns,Rows,Tuples per second,Bytes per second," << PLACEMENT_HEADER
+             << ",Distribution," << SUMMARY_HEADER;
+    } else if (lookupMode) {
+        cout << "Index size in KB,Data type,Thread Count,Index,Interleaving,Width,Time in ns,Lookups,"
+                "Lookups per second,Time per lookup in ns,Index bytes," << PLACEMENT_HEADER << "," << SUMMARY_HEADER;
+    } else if (latencyMode) {
+        cout << "Working set in KB,Chains,Thread Count,Time in ns,Latency in ns,Latency in cycles," << PLACEMENT_HEADER
+             << ",Median latency in ns,P5 latency in ns,P95 latency in ns,Stddev latency in ns,Samples";
+    } else {
+        cout << "Column size in KB,Data type,Time in ns,Thread Count,DB type,Kernel,Predicate,Predicate columns,"
+                "Branching,Selectivity,Output,Write time in ns,Output bytes,Packing,Rows,Tuples per second,"
+                "Bytes per second," << PLACEMENT_HEADER << ",Distribution,Aggregate," << SUMMARY_HEADER
+             << ",Scheduling,Makespan in ns,Max thread time in ns,Min thread time in ns,Roofline limit,"
+                "Roofline bytes per second,Fraction of roofline";
+    }
+    if (outputFormat == OutputFormat::Csv) {
+        for (auto &event: counterEvents) {
+            cout << ",Counter " << event.name;
+        }
+        cout << endl;
+    }
+    auto benchmarkTypes = [&](size_t size, const ScanOptions &options) {
+        vector<Results> results;
         if (useInt8) {
-            benchmark<int8_t>(size, colCount, threadCount, dynamicIterations, sampleSize, randomInit);
+            results.push_back(benchmark<int8_t>(size, colCount, threadCount, sampling, randomInit, options));
         }
         if (useInt16) {
-            benchmark<int16_t>(size, colCount, threadCount, dynamicIterations, sampleSize, randomInit);
+            results.push_back(benchmark<int16_t>(size, colCount, threadCount, sampling, randomInit, options));
         }
         if (useInt32) {
-            benchmark<int32_t>(size, colCount, threadCount, dynamicIterations, sampleSize, randomInit);
+            results.push_back(benchmark<int32_t>(size, colCount, threadCount, sampling, randomInit, options));
         }
         if (useInt64) {
-            benchmark<int64_t>(size, colCount, threadCount, dynamicIterations, sampleSize, randomInit);
+            results.push_back(benchmark<int64_t>(size, colCount, threadCount, sampling, randomInit, options));
         }
+        for (auto bitWidth: packedWidths) {
+            results.push_back(benchmarkPacked(bitWidth, size, threadCount, sampling, randomInit, options));
+        }
+        for (auto &result: results) {
+            double relError = medianRelativeError(vector<double>(result.times.begin(), result.times.end()));
+            if (sampling.relError > 0 && relError > sampling.relError) {
+                cerr << result.dataType << ": time budget used up at a relative error of " << relError << endl;
+            }
+        }
+        return results;
+    };
+
+    vector<PrefetchGrid> prefetchGrids; // per access pattern and data type, in the order they are benchmarked
+    auto benchmarkPrefetchTypes = [&](size_t size) {
+        size_t grid = 0;
+        auto next = [&]() -> PrefetchGrid & {
+            if (prefetchGrids.size() <= grid) prefetchGrids.emplace_back();
+            return prefetchGrids[grid++];
+        };
+        for (auto access: accesses) {
+            if (useInt8) {
+                benchmarkPrefetch<int8_t>(access, size, distances, threadCount, sampling, randomInit, options, next());
+            }
+            if (useInt16) {
+                benchmarkPrefetch<int16_t>(access, size, distances, threadCount, sampling, randomInit, options,
+                                           next());
+            }
+            if (useInt32) {
+                benchmarkPrefetch<int32_t>(access, size, distances, threadCount, sampling, randomInit, options,
+                                           next());
+            }
+            if (useInt64) {
+                benchmarkPrefetch<int64_t>(access, size, distances, threadCount, sampling, randomInit, options,
+                                           next());
+            }
+        }
+    };
+
+    // hugetlbfs pages have to be reserved up front, so allocations can fail with any --pages but default and small
+    try {
+        for (size_t m = 0; m < max<size_t>(1, prefetcherMasks.size()); m++) {
+            if (!prefetcherMasks.empty()) {
+                if (!prefetchers->set(prefetcherMasks[m])) {
+                    cerr << "cannot set the prefetchers to " << prefetcherMaskLabel(prefetcherMasks[m]) << endl;
+                    return 1;
+                }
+                prefetcherMask = prefetcherMasks[m];
+                prefetcherLabel = prefetcherMaskLabel(prefetcherMask);
+                cerr << "prefetchers " << prefetcherLabel << endl;
+            }
+            // the NUMA matrix leaves the threads on the CPUs of the last node
+            if (m > 0 && numaMatrix) workerPool.reset(new WorkerPool(threadCount, cpus));
+            // the prefetchers change the bandwidth, so every mask gets a roofline of its own, on the CPUs of the run
+            if (rooflineCalibration) measureRoofline(caches, threadCount, sampling);
+            prefetchGrids.clear();
+            for (auto size: sizes) {
+                cerr << "benchmarking " << (size / 1024.0f) << " KiB" << endl;
+
+                if (latencyMode) {
+                    for (auto chainCount: chains) benchmarkLatency(size, chainCount, threadCount, sampling, options);
+                    continue;
+                } else if (tableMode) {
+                    for (auto layout: layouts) {
+                        benchmarkTable(layout, size, widths, attributeCounts, groupRows, threadCount, sampling,
+                                       randomInit, options);
+                    }
+                    continue;
+                } else if (joinMode) {
+                    for (auto algorithm: joins) {
+                        if (useInt32) benchmarkJoin<int32_t>(algorithm, size, threadCount, sampling, options, join);
+                        if (useInt64) benchmarkJoin<int64_t>(algorithm, size, threadCount, sampling, options, join);
+                    }
+                    continue;
+                } else if (prefetchMode) {
+                    benchmarkPrefetchTypes(size);
+                    continue;
+                } else if (mixedMode) {
+                    if (useInt8) {
+                        benchmarkMixed<int8_t>(size, threadCount, writers, writerStores, sampling, randomInit, options);
+                    }
+                    if (useInt16) {
+                        benchmarkMixed<int16_t>(size, threadCount, writers, writerStores, sampling, randomInit,
+                                                options);
+                    }
+                    if (useInt32) {
+                        benchmarkMixed<int32_t>(size, threadCount, writers, writerStores, sampling, randomInit,
+                                                options);
+                    }
+                    if (useInt64) {
+                        benchmarkMixed<int64_t>(size, threadCount, writers, writerStores, sampling, randomInit,
+                                                options);
+                    }
+                    continue;
+                } else if (fileMode) {
+                    if (useInt8) {
+                        benchmarkFile<int8_t>(fileAccesses, pageCaches, size, columnDirectory, prepareFiles,
+                                              threadCount, sampling, randomInit, options);
+                    }
+                    if (useInt16) {
+                        benchmarkFile<int16_t>(fileAccesses, pageCaches, size, columnDirectory, prepareFiles,
+                                               threadCount, sampling, randomInit, options);
+                    }
+                    if (useInt32) {
+                        benchmarkFile<int32_t>(fileAccesses, pageCaches, size, columnDirectory, prepareFiles,
+                                               threadCount, sampling, randomInit, options);
+                    }
+                    if (useInt64) {
+                        benchmarkFile<int64_t>(fileAccesses, pageCaches, size, columnDirectory, prepareFiles,
+                                               threadCount, sampling, randomInit, options);
+                    }
+                    continue;
+                } else if (lookupMode) {
+                    for (auto index: indexes) {
+                        if (useInt32) {
+                            benchmarkLookup<int32_t>(index, interleavings, interleaveWidths, size, lookupCount,
+                                                     threadCount, sampling, options);
+                        }
+                        if (useInt64) {
+                            benchmarkLookup<int64_t>(index, interleavings, interleaveWidths, size, lookupCount,
+                                                     threadCount, sampling, options);
+                        }
+                    }
+                    continue;
+                } else if (writeMode) {
+                    for (auto kind: writes) {
+                        if (useInt8) benchmarkWrite<int8_t>(kind, size, threadCount, sampling, randomInit, options);
+                        if (useInt16) benchmarkWrite<int16_t>(kind, size, threadCount, sampling, randomInit, options);
+                        if (useInt32) benchmarkWrite<int32_t>(kind, size, threadCount, sampling, randomInit, options);
+                        if (useInt64) benchmarkWrite<int64_t>(kind, size, threadCount, sampling, randomInit, options);
+                    }
+                    continue;
+                } else if (!numaMatrix) {
+                    benchmarkTypes(size, options);
+                    continue;
+                }
+
+                // every (CPU node, memory node) pair, with all threads on the CPUs of one node
+                auto nodes = onlineNodes();
+                vector<int> cpuNodes;
+                vector<vector<vector<Results>>> matrix; // [CPU node][memory node][data type]
+                for (auto cpuNode: nodes) {
+                    auto cpus = nodeCpus(cpuNode);
+                    if (cpus.empty()) continue;
+                    workerPool.reset(new WorkerPool(threadCount, cpus));
+                    cpuNodes.push_back(cpuNode);
+                    matrix.emplace_back();
+                    for (auto memoryNode: nodes) {
+                        auto pairOptions = options;
+                        pairOptions.placement = Placement::Node;
+                        pairOptions.memoryNode = memoryNode;
+                        matrix.back().push_back(benchmarkTypes(size, pairOptions));
+                    }
+                }
+
+                // mean bandwidth and scan time per pair, CPU nodes in rows and memory nodes in columns
+                for (size_t type = 0; type < matrix[0][0].size(); type++) {
+                    cerr << matrix[0][0][type].dataType << ", " << (size / 1024.0f) << " KiB: GB/s | ns per scan"
+                         << endl;
+                    cerr << "cpu\\mem";
+                    for (auto memoryNode: nodes) cerr << "\t" << memoryNode;
+                    cerr << endl;
+                    for (size_t c = 0; c < cpuNodes.size(); c++) {
+                        cerr << cpuNodes[c];
+                        for (size_t m = 0; m < nodes.size(); m++) {
+                            auto &results = matrix[c][m][type];
+                            auto &times = results.times;
+                            double time = accumulate(times.begin(), times.end(), 0.0) / times.size();
+                            cerr << "\t" << results.scannedBytes / time << " | " << llround(time);
+                        }
+                        cerr << endl;
+                    }
+                }
+            }
+            if (prefetchMode) printPrefetchGrids(prefetchGrids, distances, sizes);
+        }
+    } catch (const bad_alloc &) {
+        cerr << "cannot allocate the columns with " << pageModeName(options.pages) << " pages";
+        if (ColumnAllocator::hugePageBytes(options.pages) > 1) cerr << ", reserve them with vm.nr_hugepages";
+        cerr << endl;
+        return 1;
     }
 
     return 0;
@@ -0,0 +1,95 @@
+#ifndef MORSEL_SCHEDULER_H
+#define MORSEL_SCHEDULER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "column_memory.h"
+
+/*
+ * Morsel-driven scheduling of a scan (Leis et al., SIGMOD 2014).
+ *
+ * The column is cut into morsels of a fixed number of rows. Every thread starts with the morsels of its static
+ * partition in a deque of its own, which it works through from the front. A thread whose deque is empty steals from
+ * the back of the others, first from the threads on its own NUMA node, whose morsels are local to it, then from the
+ * rest. Fast threads thus take over the work of slow ones, and the scan ends when the last morsel is done.
+ */
+
+// Range of morsel indices [head, tail) packed into one word, so taking from either end is a single compare-and-swap
+class alignas(CACHE_LINE_BYTES) MorselDeque {
+public:
+    void reset(uint32_t head, uint32_t tail) {
+        range.store(pack(head, tail), std::memory_order_relaxed);
+    }
+
+    // Takes the first morsel, for the owner
+    bool pop(uint32_t &morsel) {
+        uint64_t current = range.load(std::memory_order_relaxed);
+        do {
+            if (head(current) >= tail(current)) return false;
+        } while (!range.compare_exchange_weak(current, pack(head(current) + 1, tail(current)),
+                                              std::memory_order_relaxed));
+        morsel = head(current);
+        return true;
+    }
+
+    // Takes the last morsel, for the other threads
+    bool steal(uint32_t &morsel) {
+        uint64_t current = range.load(std::memory_order_relaxed);
+        do {
+            if (head(current) >= tail(current)) return false;
+        } while (!range.compare_exchange_weak(current, pack(head(current), tail(current) - 1),
+                                              std::memory_order_relaxed));
+        morsel = tail(current) - 1;
+        return true;
+    }
+
+private:
+    static uint64_t pack(uint32_t head, uint32_t tail) { return ((uint64_t) head << 32) | tail; }
+    static uint32_t head(uint64_t range) { return (uint32_t) (range >> 32); }
+    static uint32_t tail(uint64_t range) { return (uint32_t) range; }
+
+    std::atomic<uint64_t> range{0};
+};
+
+class MorselScheduler {
+public:
+    /*
+     * Thread t starts with morsels [firstMorsels[t], firstMorsels[t + 1]) and lives on NUMA node nodes[t]. The
+     * deques are empty until reset().
+     */
+    MorselScheduler(const std::vector<uint32_t> &firstMorsels, const std::vector<int> &nodes)
+            : firstMorsels(firstMorsels), deques(nodes.size()), victims(nodes.size()) {
+        int threads = (int) nodes.size();
+        for (int t = 0; t < threads; t++) {
+            // the threads after t first, so that the thieves of a node do not all start with the same victim
+            for (int local = 1; local >= 0; local--) {
+                for (int i = 1; i < threads; i++) {
+                    int victim = (t + i) % threads;
+                    if ((nodes[victim] == nodes[t]) == (local == 1)) victims[t].push_back(victim);
+                }
+            }
+        }
+    }
+
+    // Hands thread *t* its own morsels again, once no thread works on the previous scan anymore
+    void reset(int t) { deques[t].reset(firstMorsels[t], firstMorsels[t + 1]); }
+
+    // Next morsel of thread *t*, false once all deques are empty
+    bool next(int t, uint32_t &morsel) {
+        if (deques[t].pop(morsel)) return true;
+        for (auto victim: victims[t]) {
+            if (deques[victim].steal(morsel)) return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<uint32_t> firstMorsels;
+    std::vector<MorselDeque> deques;
+    std::vector<std::vector<int>> victims; // per thread, the order it steals in
+};
+
+#endif // MORSEL_SCHEDULER_H
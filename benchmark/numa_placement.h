@@ -0,0 +1,104 @@
+#ifndef NUMA_PLACEMENT_H
+#define NUMA_PLACEMENT_H
+
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "worker_pool.h"
+
+/*
+ * NUMA placement of the scanned columns, with the mbind system call, so that libnuma is not needed.
+ *
+ * Local placement lets every thread touch its own partition first, node placement binds the whole column to one
+ * memory node (a remote one, if the CPUs are elsewhere) and interleaved placement spreads its pages round-robin over
+ * all memory nodes.
+ */
+
+enum class Placement { Local, Node, Interleave };
+
+inline bool parsePlacement(const std::string &name, Placement &placement) {
+    if (name == "local") placement = Placement::Local;
+    else if (name == "node") placement = Placement::Node;
+    else if (name == "interleave") placement = Placement::Interleave;
+    else return false;
+    return true;
+}
+
+inline std::string placementName(Placement placement) {
+    switch (placement) {
+        case Placement::Local: return "local";
+        case Placement::Node: return "node";
+        case Placement::Interleave: return "interleave";
+    }
+    return "unknown";
+}
+
+// Memory nodes of the machine, e.g. {0, 1} for a two socket system. Machines without NUMA report node 0.
+inline std::vector<int> onlineNodes() {
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string list;
+    std::vector<int> nodes;
+    if (!(file >> list) || !parseCpuList(list, nodes)) nodes = {0};
+    return nodes;
+}
+
+// CPUs of a node, empty if the node does not exist
+inline std::vector<int> nodeCpus(int node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    std::vector<int> cpus;
+    if (!(file >> list) || !parseCpuList(list, cpus)) cpus.clear();
+    return cpus;
+}
+
+// Node of a CPU, 0 without NUMA support. The nodes of all CPUs are read from sysfs on the first call.
+inline int cpuNode(int cpu) {
+    static const std::vector<int> nodes = []() {
+        std::vector<int> cpuNodes;
+        for (auto node: onlineNodes()) {
+            for (auto nodeCpu: nodeCpus(node)) {
+                if (nodeCpu >= (int) cpuNodes.size()) cpuNodes.resize(nodeCpu + 1, 0);
+                cpuNodes[nodeCpu] = node;
+            }
+        }
+        return cpuNodes;
+    }();
+    return cpu >= 0 && cpu < (int) nodes.size() ? nodes[cpu] : 0;
+}
+
+// Label of a set of nodes for the CSV output, e.g. "0" or "0+1"
+inline std::string nodeLabel(std::vector<int> nodes) {
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    std::string label;
+    for (auto node: nodes) label += (label.empty() ? "" : "+") + std::to_string(node);
+    return label;
+}
+
+/*
+ * Sets the memory policy of [memory, memory + bytes) before any page of it is touched. The range has to start on a
+ * page boundary, which mmap guarantees. Returns false if the kernel rejects the policy, e.g. for a node without
+ * memory.
+ */
+inline bool placeMemory(void *memory, size_t bytes, Placement placement, int node) {
+    if (placement == Placement::Local || bytes == 0) return true;
+    std::vector<unsigned long> mask(1 + 1024 / (8 * sizeof(unsigned long)), 0);
+    const size_t bitsPerWord = 8 * sizeof(unsigned long);
+    if (placement == Placement::Node) {
+        if (node < 0 || node >= 1024) return false;
+        mask[node / bitsPerWord] |= 1ul << (node % bitsPerWord);
+    } else {
+        for (auto online: onlineNodes()) mask[online / bitsPerWord] |= 1ul << (online % bitsPerWord);
+    }
+    int mode = placement == Placement::Node ? MPOL_BIND : MPOL_INTERLEAVE;
+    return syscall(SYS_mbind, memory, bytes, mode, mask.data(), mask.size() * bitsPerWord, 0) == 0;
+}
+
+#endif // NUMA_PLACEMENT_H
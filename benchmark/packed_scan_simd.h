@@ -0,0 +1,92 @@
+/*
+ * Instruction set independent part of the scans on vertically bit-packed codes (see compression.h).
+ *
+ * Like scan_kernels_simd.h this file has no include guard. scan_kernels.h includes it once per instruction set,
+ * after scan_kernels_simd.h, inside a namespace that additionally provides
+ *   shiftRight32(v, n), shiftLeft32(v, n)   logical shifts of all 32 bit lanes by a runtime count below 32
+ *   and32(a, b), or32(a, b), xor32(a, b)     bitwise operations
+ * One vector holds word w of every lane of a block, so a block is decoded with plain shifts and no shuffles.
+ */
+
+// Codes are unsigned, flipping the sign bit maps their order onto the signed compares
+static inline VecT<int32_t> flipSign(VecT<int32_t> v) { return xor32(v, set1(INT32_MIN)); }
+
+// Each functor returns the match bitmask of a vector of codes
+
+struct CodeRangeMask {
+    explicit CodeRangeMask(const CodePredicate &predicate)
+            : low(set1((int32_t) (predicate.low ^ 0x80000000u))), high(set1((int32_t) (predicate.high ^ 0x80000000u))) {}
+
+    inline uint64_t operator()(VecT<int32_t> codes) const {
+        return ~toMask(outside(flipSign(codes), low, high, int32_t()), int32_t()) & allLanes<int32_t>();
+    }
+
+    VecT<int32_t> low;
+    VecT<int32_t> high;
+};
+
+struct CodeListMask {
+    explicit CodeListMask(const CodePredicate &predicate) : count(predicate.codes.size()) {
+        for (size_t i = 0; i < count; i++) needles[i] = set1((int32_t) predicate.codes[i]);
+    }
+
+    inline uint64_t operator()(VecT<int32_t> codes) const {
+        auto cmp = equal(codes, needles[0], int32_t());
+        for (size_t i = 1; i < count; i++) cmp = orCmp(cmp, equal(codes, needles[i], int32_t()));
+        return toMask(cmp, int32_t());
+    }
+
+    size_t count;
+    VecT<int32_t> needles[SIMD_IN_LIST_LIMIT];
+};
+
+// Large IN-lists probe the hash set lane by lane
+struct CodeLookupMask {
+    explicit CodeLookupMask(const CodePredicate &predicate) : predicate(predicate) {}
+
+    inline uint64_t operator()(VecT<int32_t> codes) const {
+        uint32_t values[lanes<int32_t>()];
+        memcpy(values, &codes, sizeof(values));
+        uint64_t mask = 0;
+        for (size_t lane = 0; lane < lanes<int32_t>(); lane++) {
+            mask |= (uint64_t) predicate.matches(values[lane]) << lane;
+        }
+        return mask;
+    }
+
+    const CodePredicate &predicate;
+};
+
+// *begin* has to be the first row of a block and the column must be packed with lanes<int32_t>() lanes
+template <class Mask, class Sink>
+void scanPackedColumn(const PackedColumn &column, size_t begin, size_t end, const Mask &mask, Sink &sink) {
+    const size_t width = lanes<int32_t>();
+    const unsigned bitWidth = column.bitWidth;
+    const auto codeBits = set1((int32_t) codeMask(bitWidth));
+    for (size_t block = begin / column.blockRows(); block * column.blockRows() < end; block++) {
+        auto words = reinterpret_cast<const int32_t *>(column.words.data() + block * column.blockWords());
+        size_t row = block * column.blockRows();
+        for (unsigned offset = 0; offset < 32 * bitWidth && row < end; offset += bitWidth, row += width) {
+            auto word = words + offset / 32 * width;
+            unsigned shift = offset % 32;
+            auto codes = shiftRight32(load(word), shift);
+            // codes that straddle two words get their high bits from the next one
+            if (shift + bitWidth > 32) codes = or32(codes, shiftLeft32(load(word + width), 32 - shift));
+            uint64_t matches = mask(and32(codes, codeBits));
+            if (row + width > end) matches &= (1ull << (end - row)) - 1;
+            sink(row, matches);
+        }
+    }
+    sink.finish();
+}
+
+template <class Sink>
+void scanPacked(const PackedColumn &column, size_t begin, size_t end, const CodePredicate &predicate, Sink &sink) {
+    if (predicate.usesLookup()) {
+        scanPackedColumn(column, begin, end, CodeLookupMask(predicate), sink);
+    } else if (predicate.isList()) {
+        scanPackedColumn(column, begin, end, CodeListMask(predicate), sink);
+    } else {
+        scanPackedColumn(column, begin, end, CodeRangeMask(predicate), sink);
+    }
+}
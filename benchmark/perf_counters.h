@@ -0,0 +1,149 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Hardware performance counters of the calling thread, read with perf_event_open.
+ *
+ * All events of a thread form one group, so they are scheduled onto the PMU together and count exactly the same
+ * instructions. Only user space is counted, which works with the default perf_event_paranoid setting.
+ */
+
+struct CounterEvent {
+    std::string name;
+    uint32_t type;
+    uint64_t config;
+};
+
+// Read misses in *cache*, encoded as perf_event_attr.config of a PERF_TYPE_HW_CACHE event
+static inline uint64_t cacheReadMisses(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static const char DEFAULT_COUNTERS[] = "cycles,instructions,llc-misses,l1d-misses,dtlb-misses,branch-misses";
+
+/*
+ * Accepts the names below, "rHEX" for a raw event and "name=rHEX" for a raw event with a column name. The kernel
+ * maps the generic events to the PMU of the machine. On POWER8 and newer the cache events are given as raw events,
+ * so that the columns count the same events whatever the kernel maps the generic cache events to.
+ */
+inline bool parseCounterEvent(const std::string &spec, CounterEvent &event) {
+    auto separator = spec.find('=');
+    std::string name = spec.substr(0, separator);
+    std::string code = separator == std::string::npos ? spec : spec.substr(separator + 1);
+    if (code.size() > 1 && code[0] == 'r') {
+        char *end;
+        uint64_t config = strtoull(code.c_str() + 1, &end, 16);
+        if (*end != '\0') return false;
+        event = {name, PERF_TYPE_RAW, config};
+        return true;
+    }
+    if (separator != std::string::npos) return false;
+
+    const CounterEvent known[] = {
+            {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+#ifdef _ARCH_PPC64
+            {"llc-misses", PERF_TYPE_RAW, 0x300fe}, // PM_DATA_FROM_L3MISS
+            {"l1d-misses", PERF_TYPE_RAW, 0x3e054}, // PM_LD_MISS_L1
+            {"dtlb-misses", PERF_TYPE_RAW, 0x300fc}, // PM_DTLB_MISS
+#else
+            {"llc-misses", PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_LL)},
+            {"l1d-misses", PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_L1D)},
+            {"dtlb-misses", PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_DTLB)},
+#endif
+            {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    };
+    for (auto &candidate: known) {
+        if (candidate.name == name) {
+            event = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+class CounterGroup {
+public:
+    // Events that cannot be opened are left out, their values read as NaN
+    explicit CounterGroup(const std::vector<CounterEvent> &events) : fds(events.size(), -1), ids(events.size(), 0) {
+        for (size_t i = 0; i < events.size(); i++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].type;
+            attr.config = events[i].config;
+            attr.disabled = leader == -1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+            if (fds[i] == -1) continue;
+            if (leader == -1) leader = fds[i];
+            ioctl(fds[i], PERF_EVENT_IOC_ID, &ids[i]);
+        }
+    }
+
+    CounterGroup(const CounterGroup &) = delete;
+    CounterGroup &operator=(const CounterGroup &) = delete;
+
+    ~CounterGroup() {
+        for (auto fd: fds) {
+            if (fd != -1) close(fd);
+        }
+    }
+
+    bool available(size_t event) const { return fds[event] != -1; }
+
+    void start() {
+        if (leader == -1) return;
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void stop() {
+        if (leader != -1) ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Counts on after a stop(), without a reset
+    void resume() {
+        if (leader != -1) ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Counts since start(), scaled up if the kernel had to multiplex the group with other users of the PMU
+    std::vector<double> read() const {
+        std::vector<double> values(fds.size(), NAN);
+        if (leader == -1) return values;
+        // nr, time enabled, time running, then a value and id pair per event
+        std::vector<uint64_t> buffer(3 + 2 * fds.size());
+        if (::read(leader, buffer.data(), buffer.size() * sizeof(uint64_t)) <= 0 || buffer[2] == 0) return values;
+        double scale = (double) buffer[1] / buffer[2];
+        for (uint64_t j = 0; j < buffer[0]; j++) {
+            for (size_t i = 0; i < fds.size(); i++) {
+                if (fds[i] != -1 && ids[i] == buffer[4 + 2 * j]) values[i] = buffer[3 + 2 * j] * scale;
+            }
+        }
+        return values;
+    }
+
+private:
+    int leader = -1;
+    std::vector<int> fds;
+    std::vector<uint64_t> ids;
+};
+
+#endif // PERF_COUNTERS_H
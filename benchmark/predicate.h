@@ -0,0 +1,230 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Scan predicates: equality, BETWEEN and IN-list on a single column, combined by conjunction when more than one
+ * column is scanned (every column gets the same predicate).
+ */
+
+enum class PredicateType { Equal, Between, InList };
+
+// Branchy scalar scans jump on every predicate result, predicated ones turn it into arithmetic
+enum class BranchMode { Branchy, Predicated };
+
+// IN-lists up to this size are compared with one SIMD compare per value, larger ones use a bitmap or hash set
+static const size_t SIMD_IN_LIST_LIMIT = 8;
+
+inline bool parsePredicateType(const std::string &name, PredicateType &type) {
+    if (name == "equal") type = PredicateType::Equal;
+    else if (name == "between") type = PredicateType::Between;
+    else if (name == "in") type = PredicateType::InList;
+    else return false;
+    return true;
+}
+
+inline std::string predicateTypeName(PredicateType type) {
+    switch (type) {
+        case PredicateType::Equal: return "equal";
+        case PredicateType::Between: return "between";
+        case PredicateType::InList: return "in";
+    }
+    return "unknown";
+}
+
+inline bool parseBranchMode(const std::string &name, BranchMode &mode) {
+    if (name == "branchy") mode = BranchMode::Branchy;
+    else if (name == "predicated") mode = BranchMode::Predicated;
+    else return false;
+    return true;
+}
+
+inline std::string branchModeName(BranchMode mode) {
+    return mode == BranchMode::Branchy ? "branchy" : "predicated";
+}
+
+// Open addressing set for large IN-lists on 32 and 64 bit values
+template <class T>
+class HashSet {
+public:
+    explicit HashSet(const std::vector<T> &values) {
+        size_t capacity = 16;
+        while (capacity < 2 * values.size()) capacity *= 2;
+        mask = capacity - 1;
+        slots.assign(capacity, 0);
+        used.assign(capacity, 0);
+        for (auto value: values) {
+            size_t slot = hash(value);
+            while (used[slot] && slots[slot] != value) slot = (slot + 1) & mask;
+            slots[slot] = value;
+            used[slot] = 1;
+        }
+    }
+
+    bool contains(T value) const {
+        size_t slot = hash(value);
+        while (used[slot]) {
+            if (slots[slot] == value) return true;
+            slot = (slot + 1) & mask;
+        }
+        return false;
+    }
+
+private:
+    size_t hash(T value) const {
+        return (size_t) (((uint64_t) value * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    size_t mask;
+    std::vector<T> slots;
+    std::vector<uint8_t> used;
+};
+
+template <class T>
+class Predicate {
+public:
+    typedef typename std::make_unsigned<T>::type Unsigned;
+
+    static Predicate equal(T value) {
+        Predicate predicate(PredicateType::Equal);
+        predicate.low = predicate.high = value;
+        return predicate;
+    }
+
+    static Predicate between(T low, T high) {
+        Predicate predicate(PredicateType::Between);
+        predicate.low = low;
+        predicate.high = high;
+        return predicate;
+    }
+
+    static Predicate inList(std::vector<T> values) {
+        Predicate predicate(PredicateType::InList);
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        predicate.values = values;
+        predicate.low = values.front();
+        predicate.high = values.back();
+        if (values.size() > SIMD_IN_LIST_LIMIT) {
+            if (sizeof(T) <= 2) {
+                predicate.bitmap.assign(((size_t) 1 << (8 * sizeof(T))) / 64, 0);
+                for (auto value: values) {
+                    auto bit = (Unsigned) value;
+                    predicate.bitmap[bit / 64] |= 1ull << (bit % 64);
+                }
+            } else {
+                predicate.hashSet = std::make_shared<HashSet<T>>(values);
+            }
+        }
+        return predicate;
+    }
+
+    PredicateType type() const { return predicateType; }
+
+    bool usesLookup() const { return predicateType == PredicateType::InList && values.size() > SIMD_IN_LIST_LIMIT; }
+
+    inline bool matches(T value) const {
+        switch (predicateType) {
+            case PredicateType::Equal:
+                return value == low;
+            case PredicateType::Between:
+                return value >= low && value <= high;
+            case PredicateType::InList:
+                return lookup(value);
+        }
+        return false;
+    }
+
+    // Bitmap or hash probe for large lists, linear search for small ones
+    inline bool lookup(T value) const {
+        if (!bitmap.empty()) {
+            auto bit = (Unsigned) value;
+            return (bitmap[bit / 64] >> (bit % 64)) & 1;
+        } else if (hashSet) {
+            return hashSet->contains(value);
+        }
+        bool found = false;
+        for (auto candidate: values) found |= candidate == value;
+        return found;
+    }
+
+    // Draws a value that satisfies the predicate
+    template <class Generator>
+    T matchingValue(Generator &generator) const {
+        switch (predicateType) {
+            case PredicateType::Equal:
+                return low;
+            case PredicateType::Between:
+                return std::uniform_int_distribution<int64_t>(low, high)(generator);
+            case PredicateType::InList:
+                return values[std::uniform_int_distribution<size_t>(0, values.size() - 1)(generator)];
+        }
+        return low;
+    }
+
+    // Draws a value that does not satisfy the predicate. Ranges are sampled outside of [low, high] directly,
+    // everything else by rejection, which is cheap because predicates only cover a small part of the domain.
+    template <class Generator>
+    T nonMatchingValue(Generator &generator) const {
+        std::uniform_int_distribution<int64_t> any(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+        if (predicateType == PredicateType::Between) {
+            // differences are computed modulo 2^64 so that they cannot overflow for int64
+            uint64_t below = (uint64_t) (int64_t) low - (uint64_t) (int64_t) std::numeric_limits<T>::min();
+            uint64_t above = (uint64_t) (int64_t) std::numeric_limits<T>::max() - (uint64_t) (int64_t) high;
+            if (std::uniform_int_distribution<uint64_t>(1, below + above)(generator) <= below) {
+                return std::uniform_int_distribution<int64_t>(std::numeric_limits<T>::min(), low - 1)(generator);
+            }
+            return std::uniform_int_distribution<int64_t>(high + 1, std::numeric_limits<T>::max())(generator);
+        }
+        T value;
+        do {
+            value = (T) any(generator);
+        } while (matches(value));
+        return value;
+    }
+
+    T low;
+    T high;
+    std::vector<T> values;
+
+private:
+    explicit Predicate(PredicateType type) : low(0), high(0), predicateType(type) {}
+
+    PredicateType predicateType;
+    std::vector<uint64_t> bitmap;
+    std::shared_ptr<HashSet<T>> hashSet;
+};
+
+/*
+ * Builds the predicate used by the benchmark. The constants are fixed so that only the data decides the selectivity:
+ * equality compares against 0, BETWEEN accepts [0, 100] and the IN-list holds the even numbers 0, 2, 4, ...
+ */
+template <class T>
+Predicate<T> makePredicate(PredicateType type, size_t inListSize) {
+    switch (type) {
+        case PredicateType::Between:
+            return Predicate<T>::between(0, 100);
+        case PredicateType::InList: {
+            // leave the odd numbers and the negative half of the domain for non-matching values
+            size_t maxSize = (size_t) std::numeric_limits<T>::max() / 2;
+            std::vector<T> values;
+            for (size_t i = 0; i < std::max<size_t>(1, std::min(inListSize, maxSize)); i++) {
+                values.push_back((T) (2 * i));
+            }
+            return Predicate<T>::inList(values);
+        }
+        default:
+            return Predicate<T>::equal(0);
+    }
+}
+
+#endif // PREDICATE_H
@@ -0,0 +1,212 @@
+#ifndef PREFETCHER_CONTROL_H
+#define PREFETCHER_CONTROL_H
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "worker_pool.h"
+
+/*
+ * Hardware prefetcher control of Intel cores, through MSR 0x1a4 with the msr module (/dev/cpu/N/msr) as root. A set
+ * bit of the MSR disables a prefetcher:
+ *
+ *   bit 0  L2 hardware prefetcher (streamer)
+ *   bit 1  L2 adjacent cache line prefetcher
+ *   bit 2  DCU (L1 data cache) next line prefetcher
+ *   bit 3  DCU IP prefetcher (L1 data cache prefetches based on the instruction address)
+ *
+ * See https://software.intel.com/en-us/articles/disclosure-of-hw-prefetcher-control-on-some-intel-processors.
+ *
+ * The masks here are the other way round, a set bit enables the prefetcher, so 0xf has all of them on. The other bits
+ * of the MSR are kept. The value of every CPU is saved before the first write and written back when the control is
+ * destroyed, at exit() and on the signals that end a run, so an interrupted benchmark does not leave the machine
+ * with its prefetchers off.
+ */
+
+static const uint32_t PREFETCH_MSR = 0x1a4;
+static const unsigned ALL_PREFETCHERS = 0xf;
+
+// e.g. "0xf", the CSV value of a mask
+inline std::string prefetcherMaskLabel(unsigned mask) {
+    std::ostringstream label;
+    label << "0x" << std::hex << mask;
+    return label.str();
+}
+
+// Accepts 0 to 15 in decimal or hex, e.g. 0x5
+inline bool parsePrefetcherMask(const std::string &text, unsigned &mask) {
+    char *end;
+    unsigned long value = strtoul(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || value > ALL_PREFETCHERS) return false;
+    mask = (unsigned) value;
+    return true;
+}
+
+/*
+ * Name of an Intel family 6 model with the four prefetcher bits in MSR 0x1a4, empty for any other CPU. Core 2 keeps
+ * them elsewhere, and the Atom and Xeon Phi cores have fewer prefetchers.
+ */
+inline std::string prefetchControlModel(int model) {
+    switch (model) {
+        case 26: case 30: case 31: case 46: return "Nehalem";
+        case 37: case 44: case 47: return "Westmere";
+        case 42: case 45: return "Sandy Bridge";
+        case 58: case 62: return "Ivy Bridge";
+        case 60: case 63: case 69: case 70: return "Haswell";
+        case 61: case 71: case 79: case 86: return "Broadwell";
+        case 78: case 94: return "Skylake";
+        case 85: return "Skylake-SP, Cascade Lake or Cooper Lake";
+        case 142: case 158: case 165: case 166: return "Kaby Lake, Coffee Lake or Comet Lake";
+        case 102: return "Cannon Lake";
+        case 106: case 108: return "Ice Lake-SP";
+        case 125: case 126: return "Ice Lake";
+        case 140: case 141: return "Tiger Lake";
+        case 167: return "Rocket Lake";
+        case 143: return "Sapphire Rapids";
+        case 207: return "Emerald Rapids";
+        case 173: case 174: return "Granite Rapids";
+        case 151: case 154: return "Alder Lake";
+        case 183: case 186: case 191: return "Raptor Lake";
+        default: return "";
+    }
+}
+
+// Model of the first CPU in /proc/cpuinfo, -1 for anything but an Intel family 6 CPU
+inline int intelFamily6Model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line, vendor;
+    int family = -1, model = -1;
+    while (std::getline(cpuinfo, line) && (vendor.empty() || family < 0 || model < 0)) {
+        auto separator = line.find(':');
+        if (separator == std::string::npos) continue;
+        auto key = line.substr(0, line.find_last_not_of(" \t", separator - 1) + 1);
+        auto value = line.substr(separator + 1);
+        if (key == "vendor_id") std::istringstream(value) >> vendor;
+        else if (key == "cpu family") family = atoi(value.c_str());
+        else if (key == "model") model = atoi(value.c_str());
+    }
+    return vendor == "GenuineIntel" && family == 6 ? model : -1;
+}
+
+// CPUs that are online, which can be more than the process may use
+inline std::vector<int> onlineCpus() {
+    std::ifstream file("/sys/devices/system/cpu/online");
+    std::string list;
+    std::vector<int> cpus;
+    if (!(file >> list) || !parseCpuList(list, cpus)) cpus.clear();
+    return cpus;
+}
+
+class PrefetcherControl {
+public:
+    // Opens the MSR of every CPU and saves its value, error() tells why if that fails
+    PrefetcherControl(const std::vector<int> &cpus, bool restoreOnExit) : restoreOnExit(restoreOnExit) {
+        int model = intelFamily6Model();
+        modelName = prefetchControlModel(model);
+        if (modelName.empty()) {
+            errorText = model < 0 ? "not an Intel family 6 CPU" : "unsupported Intel model " + std::to_string(model);
+            return;
+        }
+        for (auto cpu: cpus) {
+            auto path = "/dev/cpu/" + std::to_string(cpu) + "/msr";
+            int fd = open(path.c_str(), O_RDWR);
+            uint64_t value;
+            if (fd < 0 || pread(fd, &value, sizeof(value), PREFETCH_MSR) != sizeof(value)) {
+                errorText = "cannot access " + path + " (load the msr module and run as root)";
+                if (fd >= 0) close(fd);
+                return;
+            }
+            this->cpus.push_back(cpu);
+            fds.push_back(fd);
+            saved.push_back(value);
+        }
+        if (fds.empty()) {
+            errorText = "no CPUs";
+            return;
+        }
+        if (restoreOnExit) {
+            active() = this;
+            atexit(restoreActive);
+            for (int signal: {SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGABRT}) std::signal(signal, restoreAndRaise);
+        }
+    }
+
+    ~PrefetcherControl() {
+        if (restoreOnExit) restore();
+        if (active() == this) active() = nullptr;
+        for (auto fd: fds) close(fd);
+    }
+
+    PrefetcherControl(const PrefetcherControl &) = delete;
+    PrefetcherControl &operator=(const PrefetcherControl &) = delete;
+
+    bool ok() const { return errorText.empty(); }
+    const std::string &error() const { return errorText; }
+    const std::string &model() const { return modelName; }
+
+    // Enables the prefetchers of *mask* on every CPU and disables the others, false if a CPU did not take it
+    bool set(unsigned mask) {
+        for (size_t c = 0; c < fds.size(); c++) {
+            uint64_t value = (saved[c] & ~(uint64_t) ALL_PREFETCHERS) | (~mask & ALL_PREFETCHERS), check;
+            if (pwrite(fds[c], &value, sizeof(value), PREFETCH_MSR) != sizeof(value) ||
+                pread(fds[c], &check, sizeof(check), PREFETCH_MSR) != sizeof(check) || check != value) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Enabled prefetchers of every CPU, as set() takes them
+    std::vector<unsigned> masks() const {
+        std::vector<unsigned> result;
+        for (auto fd: fds) {
+            uint64_t value = 0;
+            if (pread(fd, &value, sizeof(value), PREFETCH_MSR) != sizeof(value)) value = ALL_PREFETCHERS;
+            result.push_back((unsigned) (~value & ALL_PREFETCHERS));
+        }
+        return result;
+    }
+
+    // Writes back the saved values, only pwrite, so it is safe in a signal handler
+    void restore() const {
+        for (size_t c = 0; c < fds.size(); c++) {
+            ssize_t written = pwrite(fds[c], &saved[c], sizeof(saved[c]), PREFETCH_MSR);
+            (void) written;
+        }
+    }
+
+private:
+    // The control that restores at exit and on signals, there is one per process
+    static PrefetcherControl *&active() {
+        static PrefetcherControl *control = nullptr;
+        return control;
+    }
+
+    static void restoreActive() {
+        if (active()) active()->restore();
+    }
+
+    static void restoreAndRaise(int signal) {
+        restoreActive();
+        std::signal(signal, SIG_DFL);
+        raise(signal);
+    }
+
+    bool restoreOnExit;
+    std::string modelName;
+    std::string errorText;
+    std::vector<int> cpus;
+    std::vector<int> fds;
+    std::vector<uint64_t> saved;
+};
+
+#endif // PREFETCHER_CONTROL_H
@@ -0,0 +1,156 @@
+#ifndef RESULT_SINKS_H
+#define RESULT_SINKS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Result materialization of a scan.
+ *
+ * Vector kernels call sink(index, mask) with one bit per row of a block that starts at row index, the scalar kernel
+ * calls sink.match(index) for every qualifying row (branchy) or sink.predicated(index, match) for every row.
+ * Blocks are lanes-aligned relative to the first row of the scan and never straddle a 64 bit word of the bitmap.
+ * Every sink also counts the qualifying rows.
+ */
+
+enum class OutputMode { Count, Bitmap, Positions32, Positions64, Values };
+
+inline bool parseOutputMode(const std::string &name, OutputMode &mode) {
+    if (name == "count") mode = OutputMode::Count;
+    else if (name == "bitmap") mode = OutputMode::Bitmap;
+    else if (name == "positions32") mode = OutputMode::Positions32;
+    else if (name == "positions64") mode = OutputMode::Positions64;
+    else if (name == "values") mode = OutputMode::Values;
+    else return false;
+    return true;
+}
+
+inline std::string outputModeName(OutputMode mode) {
+    switch (mode) {
+        case OutputMode::Count: return "count";
+        case OutputMode::Bitmap: return "bitmap";
+        case OutputMode::Positions32: return "positions32";
+        case OutputMode::Positions64: return "positions64";
+        case OutputMode::Values: return "values";
+    }
+    return "unknown";
+}
+
+// Vector stores of compacted values may write up to one full vector past the last qualifying value
+static const size_t OUTPUT_SLACK_BYTES = 64;
+
+// Size of the output buffer for a scan of *rows* rows of elementSize bytes
+inline size_t outputBufferBytes(OutputMode mode, size_t rows, size_t elementSize) {
+    switch (mode) {
+        case OutputMode::Count: return 0;
+        case OutputMode::Bitmap: return (rows + 63) / 64 * sizeof(uint64_t);
+        case OutputMode::Positions32: return rows * sizeof(uint32_t);
+        case OutputMode::Positions64: return rows * sizeof(uint64_t);
+        case OutputMode::Values: return rows * elementSize + OUTPUT_SLACK_BYTES;
+    }
+    return 0;
+}
+
+// Bytes one scan writes for *matches* qualifying rows
+inline size_t outputBytesWritten(OutputMode mode, size_t rows, size_t matches, size_t elementSize) {
+    switch (mode) {
+        case OutputMode::Count: return 0;
+        case OutputMode::Bitmap: return (rows + 63) / 64 * sizeof(uint64_t);
+        case OutputMode::Positions32: return matches * sizeof(uint32_t);
+        case OutputMode::Positions64: return matches * sizeof(uint64_t);
+        case OutputMode::Values: return matches * elementSize;
+    }
+    return 0;
+}
+
+// Keeps the compiler from discarding a computation whose result is otherwise unused, without any memory traffic
+template <class T>
+inline void doNotOptimize(const T &value) {
+    __asm__ __volatile__("" : : "r,m"(value) : "memory");
+}
+
+struct CountSink {
+    inline void operator()(size_t, uint64_t mask) { count += __builtin_popcountll(mask); }
+    inline void match(size_t) { count++; }
+    inline void predicated(size_t, bool match) { count += match; }
+    inline void finish() {}
+
+    uint64_t count = 0;
+};
+
+// Dense bitvector, bit i belongs to row begin + i
+struct BitmapSink {
+    BitmapSink(uint64_t *out, size_t begin, size_t end) : out(out), begin(begin), end(end) {}
+
+    inline void operator()(size_t index, uint64_t mask) {
+        size_t position = index - begin;
+        // rows without a match never reach match(), so skipped words have to be written as well
+        while (position / 64 != word) {
+            out[word++] = current;
+            current = 0;
+        }
+        current |= mask << (position % 64);
+        count += __builtin_popcountll(mask);
+    }
+    inline void match(size_t index) { (*this)(index, 1); }
+    inline void predicated(size_t index, bool match) { (*this)(index, match); }
+    inline void finish() {
+        if (end == begin) return;
+        while (word < (end - 1 - begin) / 64) {
+            out[word++] = current;
+            current = 0;
+        }
+        out[word] = current;
+    }
+
+    uint64_t *out;
+    size_t begin;
+    size_t end;
+    size_t word = 0;
+    uint64_t current = 0;
+    uint64_t count = 0;
+};
+
+// Row ids of the qualifying rows
+template <class P>
+struct PositionSink {
+    explicit PositionSink(P *out) : out(out) {}
+
+    inline void operator()(size_t index, uint64_t mask) {
+        while (mask) {
+            out[count++] = (P) (index + __builtin_ctzll(mask));
+            mask &= mask - 1;
+        }
+    }
+    inline void match(size_t index) { out[count++] = (P) index; }
+    inline void predicated(size_t index, bool match) {
+        out[count] = (P) index;
+        count += match;
+    }
+    inline void finish() {}
+
+    P *out;
+    uint64_t count = 0;
+};
+
+// Values of the qualifying rows of *column*, for the scalar kernel. The vector kernels use their own left-pack.
+template <class T>
+struct ScalarValueSink {
+    ScalarValueSink(T *out, const T *column, size_t stride) : out(out), column(column), stride(stride) {}
+
+    inline void match(size_t index) { out[count++] = column[index * stride]; }
+    inline void predicated(size_t index, bool match) {
+        out[count] = column[index * stride];
+        count += match;
+    }
+    inline void finish() {}
+
+    T *out;
+    const T *column;
+    size_t stride;
+    uint64_t count = 0;
+};
+
+#endif // RESULT_SINKS_H
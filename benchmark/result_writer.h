@@ -0,0 +1,212 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "worker_pool.h"
+
+/*
+ * Structured output: one JSON object per line and sample (JSON Lines), with typed fields that pandas, Spark or
+ * DuckDB read straight into a table, and that Parquet can store without conversion. Sizes are in bytes and times in
+ * nanoseconds, numbers are never formatted for humans. Every record carries the metadata of the run, so the records
+ * of many runs can go into one dataset.
+ */
+
+enum class OutputFormat { Csv, Json };
+
+inline bool parseOutputFormat(const std::string &name, OutputFormat &format) {
+    if (name == "csv") format = OutputFormat::Csv;
+    else if (name == "json") format = OutputFormat::Json;
+    else return false;
+    return true;
+}
+
+// Fields of one JSON object, in the order they are added
+class JsonRecord {
+public:
+    JsonRecord &field(const std::string &name, const std::string &value) { return raw(name, quote(value)); }
+    JsonRecord &field(const std::string &name, const char *value) { return raw(name, quote(value)); }
+    JsonRecord &field(const std::string &name, bool value) { return raw(name, value ? "true" : "false"); }
+    JsonRecord &field(const std::string &name, int value) { return raw(name, std::to_string(value)); }
+    JsonRecord &field(const std::string &name, long value) { return raw(name, std::to_string(value)); }
+    JsonRecord &field(const std::string &name, long long value) { return raw(name, std::to_string(value)); }
+    JsonRecord &field(const std::string &name, unsigned value) { return raw(name, std::to_string(value)); }
+    JsonRecord &field(const std::string &name, unsigned long value) { return raw(name, std::to_string(value)); }
+    JsonRecord &field(const std::string &name, unsigned long long value) { return raw(name, std::to_string(value)); }
+    JsonRecord &field(const std::string &name, double value) { return raw(name, number(value)); }
+
+    template <class T>
+    JsonRecord &field(const std::string &name, const std::vector<T> &values) {
+        std::string list = "[";
+        for (size_t i = 0; i < values.size(); i++) list += (i > 0 ? "," : "") + JsonRecord().element(values[i]);
+        return raw(name, list + "]");
+    }
+
+    JsonRecord &null(const std::string &name) { return raw(name, "null"); }
+
+    // Appends the fields of *other*
+    JsonRecord &merge(const JsonRecord &other) {
+        if (!other.fields.empty()) fields += (fields.empty() ? "" : ",") + other.fields;
+        return *this;
+    }
+
+    std::string str() const { return "{" + fields + "}"; }
+
+private:
+    JsonRecord &raw(const std::string &name, const std::string &value) {
+        fields += (fields.empty() ? "" : ",") + quote(name) + ":" + value;
+        return *this;
+    }
+
+    std::string element(const std::string &value) const { return quote(value); }
+    std::string element(double value) const { return number(value); }
+    template <class T>
+    std::string element(T value) const { return std::to_string(value); }
+
+    // NaN and infinity are not JSON, they become null
+    static std::string number(double value) {
+        if (!std::isfinite(value)) return "null";
+        char text[32];
+        snprintf(text, sizeof(text), "%.17g", value);
+        return text;
+    }
+
+    static std::string quote(const std::string &value) {
+        std::string quoted = "\"";
+        for (unsigned char c: value) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+                quoted += (char) c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                quoted += escaped;
+            } else {
+                quoted += (char) c;
+            }
+        }
+        return quoted + "\"";
+    }
+
+    std::string fields;
+};
+
+// Set by CMake, empty when built without it
+#ifndef BENCHMARK_GIT_REVISION
+#define BENCHMARK_GIT_REVISION ""
+#endif
+#ifndef BENCHMARK_CXX_FLAGS
+#define BENCHMARK_CXX_FLAGS ""
+#endif
+
+// "model name" on x86, "cpu" on POWER
+inline std::string cpuModelName() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        auto separator = line.find(':');
+        if (separator == std::string::npos) continue;
+        auto key = line.substr(0, line.find_last_not_of(" \t", separator - 1) + 1);
+        if (key == "model name" || key == "cpu") {
+            auto value = line.substr(separator + 1);
+            return value.substr(std::min(value.size(), value.find_first_not_of(" \t")));
+        }
+    }
+    return "";
+}
+
+// Hardware threads of the core of *cpu* that are online, e.g. 8 on POWER8 with SMT-8. 0 if unknown.
+inline int smtLevel(int cpu) {
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+    std::string list;
+    std::vector<int> siblings;
+    if (!(file >> list) || !parseCpuList(list, siblings)) return 0;
+    return (int) siblings.size();
+}
+
+// Data stream control register of *cpu* on POWER, which sets the prefetch depth, -1 elsewhere
+inline long powerDscr(int cpu) {
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/dscr");
+    std::string value;
+    if (!(file >> value)) return -1;
+    return strtol(value.c_str(), nullptr, 0);
+}
+
+// What a run was measured on and with, the same for all of its records
+struct RunMetadata {
+    std::string mode; // --mode
+    std::string startTime; // UTC, ISO 8601
+    std::string host;
+    std::string cpuModel;
+    int smtLevel; // 0: unknown
+    long dscr; // -1: not POWER
+    std::string compiler;
+    std::string compilerFlags;
+    std::string gitRevision;
+    std::vector<std::string> arguments;
+    // per cache level the threads use, see size_sweep.h
+    std::vector<int> cacheLevels;
+    std::vector<size_t> cacheBytes;
+    std::vector<int> cacheInstances;
+    std::vector<int> cacheSharingCpus;
+    // per level of the roofline, in bytes per second, empty without one, see roofline.h
+    std::vector<std::string> rooflineLevels;
+    std::vector<double> rooflineRead;
+    std::vector<double> rooflineWrite;
+    std::vector<double> rooflineCopy;
+    std::vector<double> rooflineTriad;
+    std::string compareKernel;
+    std::vector<double> compareBandwidth; // per width of the values, 1 to 8 bytes
+
+    // *cpu* is one the benchmark runs on
+    static RunMetadata collect(const std::string &mode, const std::vector<std::string> &arguments, int cpu) {
+        RunMetadata metadata;
+        metadata.mode = mode;
+        char text[256] = {};
+        time_t now = time(nullptr);
+        strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+        metadata.startTime = text;
+        if (gethostname(text, sizeof(text) - 1) == 0) metadata.host = text;
+        metadata.cpuModel = cpuModelName();
+        metadata.smtLevel = ::smtLevel(cpu);
+        metadata.dscr = powerDscr(cpu);
+#if defined(__GNUC__) && !defined(__clang__)
+        metadata.compiler = "GCC " __VERSION__;
+#else
+        metadata.compiler = __VERSION__;
+#endif
+        metadata.compilerFlags = BENCHMARK_CXX_FLAGS;
+        metadata.gitRevision = BENCHMARK_GIT_REVISION;
+        metadata.arguments = arguments;
+        return metadata;
+    }
+
+    JsonRecord record() const {
+        JsonRecord record;
+        record.field("mode", mode).field("start_time", startTime).field("host", host).field("cpu_model", cpuModel);
+        if (smtLevel > 0) record.field("smt_level", smtLevel);
+        else record.null("smt_level");
+        if (dscr >= 0) record.field("dscr", dscr);
+        else record.null("dscr");
+        record.field("compiler", compiler).field("compiler_flags", compilerFlags).field("git_revision", gitRevision)
+              .field("arguments", arguments).field("cache_levels", cacheLevels).field("cache_bytes", cacheBytes)
+              .field("cache_instances", cacheInstances).field("cache_sharing_cpus", cacheSharingCpus)
+              .field("roofline_levels", rooflineLevels).field("roofline_read_bytes_per_second", rooflineRead)
+              .field("roofline_write_bytes_per_second", rooflineWrite)
+              .field("roofline_copy_bytes_per_second", rooflineCopy)
+              .field("roofline_triad_bytes_per_second", rooflineTriad).field("compare_kernel", compareKernel)
+              .field("compare_bytes_per_second", compareBandwidth);
+        return record;
+    }
+};
+
+#endif // RESULT_WRITER_H
@@ -0,0 +1,132 @@
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*
+ * Machine limits a scan is compared with, measured once per run on the threads of the run.
+ *
+ * The bandwidth of a cache level or of DRAM is that of STREAM-style kernels on arrays of 64 bit integers:
+ *
+ *   read   sums a[i]                      8 bytes per element
+ *   write  a[i] = s                       8 bytes
+ *   copy   a[i] = b[i]                    16 bytes
+ *   triad  a[i] = b[i] + s * c[i]         24 bytes
+ *
+ * Writes are counted once, as STREAM does, although memory may see the read for ownership as well. Each thread runs
+ * the kernels on arrays of its own, which take its share of half the capacity of a level together, but at most twice
+ * that of the level below, so the peak is measured where the level is fastest. For DRAM they take four times all
+ * caches. The compute peak is the rate at which the widest scan kernel compares values that lie in the first level
+ * cache, per data type.
+ *
+ * A scan is bounded by the read bandwidth of the smallest level its data fits in and by the compare peak of its data
+ * type, whichever is lower; its roofline fraction is its bandwidth divided by that bound.
+ */
+
+enum class StreamKernel { Read, Write, Copy, Triad };
+
+static const StreamKernel STREAM_KERNELS[] = {StreamKernel::Read, StreamKernel::Write, StreamKernel::Copy,
+                                              StreamKernel::Triad};
+
+inline std::string streamKernelName(StreamKernel kernel) {
+    switch (kernel) {
+        case StreamKernel::Read: return "read";
+        case StreamKernel::Write: return "write";
+        case StreamKernel::Copy: return "copy";
+        case StreamKernel::Triad: return "triad";
+    }
+    return "unknown";
+}
+
+// Arrays a kernel works on, which share its working set
+inline int streamArrays(StreamKernel kernel) {
+    switch (kernel) {
+        case StreamKernel::Read:
+        case StreamKernel::Write: return 1;
+        case StreamKernel::Copy: return 2;
+        case StreamKernel::Triad: return 3;
+    }
+    return 1;
+}
+
+// Bytes a kernel reads and writes per element
+inline size_t streamBytes(StreamKernel kernel) {
+    return streamArrays(kernel) * sizeof(uint64_t);
+}
+
+// The kernels are left to the auto-vectorizer, on x86 in one clone per instruction set that is picked at load time
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__clang__)
+#define STREAM_CLONES __attribute__((target_clones("avx512f", "avx2", "default"), noinline))
+#else
+#define STREAM_CLONES __attribute__((noinline))
+#endif
+
+STREAM_CLONES
+static uint64_t streamRead(const uint64_t *a, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += a[i];
+    return sum;
+}
+
+STREAM_CLONES
+static void streamWrite(uint64_t *a, size_t n, uint64_t s) {
+    for (size_t i = 0; i < n; i++) a[i] = s;
+}
+
+STREAM_CLONES
+static void streamCopy(uint64_t *__restrict a, const uint64_t *__restrict b, size_t n) {
+    for (size_t i = 0; i < n; i++) a[i] = b[i];
+}
+
+STREAM_CLONES
+static void streamTriad(uint64_t *__restrict a, const uint64_t *__restrict b, const uint64_t *__restrict c, size_t n,
+                        uint64_t s) {
+    for (size_t i = 0; i < n; i++) a[i] = b[i] + s * c[i];
+}
+
+// Bandwidth of one cache level or DRAM, in bytes per second of all threads
+struct RooflineLevel {
+    std::string name; // e.g. L2 or DRAM
+    size_t capacity; // of all caches of the level the threads use, the maximum for DRAM
+    double bandwidth[4]; // per StreamKernel
+};
+
+struct Roofline {
+    std::vector<RooflineLevel> levels; // ascending, DRAM last
+    std::string compareKernel; // scan kernel of the compare peak
+    double compareBytes[4] = {}; // per data type of 1, 2, 4 and 8 bytes, of all threads
+
+    bool empty() const { return levels.empty(); }
+
+    // Level the *bytes* of a scan are read from, when the levels before *firstLevel* do not hold them
+    const RooflineLevel &level(size_t bytes, size_t firstLevel = 0) const {
+        for (size_t l = std::min(firstLevel, levels.size() - 1); l < levels.size(); l++) {
+            if (bytes <= levels[l].capacity) return levels[l];
+        }
+        return levels.back();
+    }
+
+    /*
+     * Bandwidth a scan of *bytes* can reach at most, and what bounds it, e.g. "L2 read" or "compare". Values of
+     * *elementBytes* other than 1, 2, 4 and 8 are only bounded by the bandwidth, e.g. packed codes. *firstLevel* as
+     * with level().
+     */
+    double bound(size_t bytes, size_t elementBytes, size_t firstLevel, std::string &limit) const {
+        auto &source = level(bytes, firstLevel);
+        double bandwidth = source.bandwidth[(int) StreamKernel::Read];
+        limit = source.name + " read";
+        int type = elementBytes == 1 ? 0 : elementBytes == 2 ? 1 : elementBytes == 4 ? 2 : elementBytes == 8 ? 3 : -1;
+        if (type >= 0 && compareBytes[type] > 0 && compareBytes[type] < bandwidth) {
+            bandwidth = compareBytes[type];
+            limit = "compare";
+        }
+        return bandwidth;
+    }
+};
+
+#endif // ROOFLINE_H
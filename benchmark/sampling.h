@@ -0,0 +1,74 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/*
+ * How many samples of how many runs a table is measured with.
+ *
+ * A sample times *iterations* back-to-back scans. Without a fixed count the iterations are calibrated so that one
+ * sample takes at least minSampleTime, which keeps the clock overhead out of the small sizes. Samples are then taken
+ * until the 95% confidence interval of the median is within relError of it, or the time budget is used up.
+ */
+struct SamplingOptions {
+    int iterations; // 0: calibrated
+    int sampleSize; // number of samples, the minimum with relError
+    int warmupSamples; // taken first and dropped
+    double relError; // 0: exactly sampleSize samples
+    double timeBudget; // seconds per table with relError
+    double minSampleTime; // seconds
+};
+
+// Statistics of the samples of a table
+struct SampleSummary {
+    double median;
+    double p5;
+    double p95;
+    double stddev;
+    size_t count;
+};
+
+// Linear interpolation between the closest ranks of sorted samples
+inline double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return NAN;
+    double rank = p * (sorted.size() - 1);
+    size_t below = (size_t) rank;
+    if (below + 1 >= sorted.size()) return sorted.back();
+    return sorted[below] + (rank - below) * (sorted[below + 1] - sorted[below]);
+}
+
+/*
+ * Half width of the distribution-free 95% confidence interval of the median, relative to the median. The interval
+ * lies between the order statistics n/2 -+ 0.98 sqrt(n) (Le Boudec, "Performance Evaluation of Computer and
+ * Communication Systems", 2010), which needs at least 6 samples.
+ */
+inline double medianRelativeError(std::vector<double> samples) {
+    size_t n = samples.size();
+    if (n < 6) return std::numeric_limits<double>::infinity();
+    std::sort(samples.begin(), samples.end());
+    double spread = 0.98 * std::sqrt((double) n);
+    size_t low = (size_t) std::max(0.0, std::floor(n / 2.0 - spread) - 1);
+    size_t high = std::min(n - 1, (size_t) std::ceil(n / 2.0 + spread));
+    double median = percentile(samples, 0.5);
+    return median > 0 ? (samples[high] - samples[low]) / 2 / median : 0;
+}
+
+inline SampleSummary summarize(std::vector<double> samples) {
+    SampleSummary summary;
+    std::sort(samples.begin(), samples.end());
+    summary.count = samples.size();
+    summary.median = percentile(samples, 0.5);
+    summary.p5 = percentile(samples, 0.05);
+    summary.p95 = percentile(samples, 0.95);
+    double mean = 0, squares = 0;
+    for (auto sample: samples) mean += sample / samples.size();
+    for (auto sample: samples) squares += (sample - mean) * (sample - mean);
+    summary.stddev = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0;
+    return summary;
+}
+
+#endif // SAMPLING_H
@@ -0,0 +1,676 @@
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "compression.h"
+#include "predicate.h"
+#include "result_sinks.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+#if defined(_ARCH_PPC64) && defined(__VSX__) && defined(__POWER8_VECTOR__)
+#include <altivec.h>
+// altivec.h may define these as macros, which breaks std::vector and bool
+#undef vector
+#undef pixel
+#undef bool
+#define HAVE_VSX_KERNELS
+#endif
+
+/*
+ * Hand-vectorized scan kernels.
+ *
+ * Every kernel evaluates a predicate over a range of rows and hands the result to a sink. The scalar kernel is kept
+ * free of auto-vectorization so that the numbers do not depend on what the compiler decides to do with the hot loop.
+ * The x86 kernels are compiled with per-region target options, so a single binary contains all of them and the
+ * matching one is picked at runtime.
+ */
+
+enum class ScanKernel { Scalar, SSE, AVX2, AVX512, VSX, Auto };
+
+#define STRINGIFY(x) #x
+
+#if defined(__clang__)
+#define SCALAR_KERNEL
+#define NO_VECTORIZE _Pragma("clang loop vectorize(disable) interleave(disable)")
+#define BEGIN_TARGET(isa) _Pragma(STRINGIFY(clang attribute push(__attribute__((target(isa))), apply_to = function)))
+#define END_TARGET _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define SCALAR_KERNEL __attribute__((optimize("no-tree-vectorize")))
+#define NO_VECTORIZE
+#define BEGIN_TARGET(isa) _Pragma("GCC push_options") _Pragma(STRINGIFY(GCC target(isa)))
+#define END_TARGET _Pragma("GCC pop_options")
+#endif
+
+// Keeps the compiler from turning a branch into a conditional move
+#define BRANCH_BARRIER() __asm__ __volatile__("")
+
+inline std::string scanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Scalar: return "scalar";
+        case ScanKernel::SSE: return "sse";
+        case ScanKernel::AVX2: return "avx2";
+        case ScanKernel::AVX512: return "avx512";
+        case ScanKernel::VSX: return "vsx";
+        case ScanKernel::Auto: return "auto";
+    }
+    return "unknown";
+}
+
+inline bool parseScanKernel(const std::string &name, ScanKernel &kernel) {
+    for (auto candidate: {ScanKernel::Scalar, ScanKernel::SSE, ScanKernel::AVX2, ScanKernel::AVX512,
+                          ScanKernel::VSX, ScanKernel::Auto}) {
+        if (scanKernelName(candidate) == name) {
+            kernel = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool scanKernelSupported(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Scalar:
+        case ScanKernel::Auto:
+            return true;
+#ifdef HAVE_X86_KERNELS
+        case ScanKernel::SSE:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case ScanKernel::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") &&
+                   __builtin_cpu_supports("popcnt");
+        case ScanKernel::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+#ifdef HAVE_VSX_KERNELS
+        case ScanKernel::VSX:
+            return true; // POWER8 and newer always have VSX
+#endif
+        default:
+            return false;
+    }
+}
+
+// Resolves *Auto* to the widest kernel the running CPU supports
+inline ScanKernel resolveScanKernel(ScanKernel kernel) {
+    if (kernel != ScanKernel::Auto) return kernel;
+    for (auto candidate: {ScanKernel::AVX512, ScanKernel::AVX2, ScanKernel::VSX, ScanKernel::SSE}) {
+        if (scanKernelSupported(candidate)) return candidate;
+    }
+    return ScanKernel::Scalar;
+}
+
+/* Scalar kernel */
+
+template <class T>
+struct EqualMatch {
+    inline bool operator()(T value) const { return value == needle; }
+    T needle;
+};
+
+template <class T>
+struct BetweenMatch {
+    inline bool operator()(T value) const { return (value >= low) & (value <= high); }
+    T low;
+    T high;
+};
+
+template <class T>
+struct LookupMatch {
+    inline bool operator()(T value) const { return predicate.lookup(value); }
+    const Predicate<T> &predicate;
+};
+
+// Left-pack for instruction sets without a compress instruction
+template <class T>
+inline size_t leftPackScalar(T *out, const T *data, uint64_t mask) {
+    size_t count = 0;
+    while (mask) {
+        out[count++] = data[__builtin_ctzll(mask)];
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+template <class T, class Match, class Sink>
+SCALAR_KERNEL void scanScalar(const T *const *columns, size_t columnCount, size_t stride, size_t begin, size_t end,
+                              const Match &match, BranchMode mode, Sink &sink) {
+    const T *column = columns[0];
+    if (mode == BranchMode::Branchy && columnCount == 1) {
+        NO_VECTORIZE
+        for (size_t j = begin; j < end; j++) {
+            if (match(column[j * stride])) {
+                BRANCH_BARRIER();
+                sink.match(j);
+            }
+        }
+    } else if (mode == BranchMode::Branchy) {
+        // short-circuit evaluation, one branch per column
+        NO_VECTORIZE
+        for (size_t j = begin; j < end; j++) {
+            size_t c = 0;
+            while (c < columnCount && match(columns[c][j * stride])) c++;
+            if (c == columnCount) {
+                BRANCH_BARRIER();
+                sink.match(j);
+            }
+        }
+    } else {
+        NO_VECTORIZE
+        for (size_t j = begin; j < end; j++) {
+            bool matches = match(column[j * stride]);
+            for (size_t c = 1; c < columnCount; c++) matches &= match(columns[c][j * stride]);
+            sink.predicated(j, matches);
+        }
+    }
+    sink.finish();
+}
+
+template <class T, class Sink>
+void scanScalar(const T *const *columns, size_t columnCount, size_t stride, size_t begin, size_t end,
+                const Predicate<T> &predicate, BranchMode mode, Sink &sink) {
+    switch (predicate.type()) {
+        case PredicateType::Equal:
+            scanScalar(columns, columnCount, stride, begin, end, EqualMatch<T>{predicate.low}, mode, sink);
+            break;
+        case PredicateType::Between:
+            scanScalar(columns, columnCount, stride, begin, end, BetweenMatch<T>{predicate.low, predicate.high},
+                       mode, sink);
+            break;
+        case PredicateType::InList:
+            scanScalar(columns, columnCount, stride, begin, end, LookupMatch<T>{predicate}, mode, sink);
+            break;
+    }
+}
+
+struct CodeMatch {
+    inline bool operator()(uint32_t code) const { return predicate.matches(code); }
+    const CodePredicate &predicate;
+};
+
+// Horizontally packed codes are decoded one at a time with an unaligned 64 bit load
+template <class Match, class Sink>
+SCALAR_KERNEL void scanHorizontalScalar(const PackedColumn &column, size_t begin, size_t end, const Match &match,
+                                        BranchMode mode, Sink &sink) {
+    if (mode == BranchMode::Branchy) {
+        NO_VECTORIZE
+        for (size_t j = begin; j < end; j++) {
+            if (match(column.horizontalCode(j))) {
+                BRANCH_BARRIER();
+                sink.match(j);
+            }
+        }
+    } else {
+        NO_VECTORIZE
+        for (size_t j = begin; j < end; j++) {
+            sink.predicated(j, match(column.horizontalCode(j)));
+        }
+    }
+    sink.finish();
+}
+
+// Vertically packed codes, decoded lane by lane into the same block masks the vector kernels produce.
+// *begin* has to be the first row of a block.
+template <class Sink>
+SCALAR_KERNEL void scanVerticalScalar(const PackedColumn &column, size_t begin, size_t end,
+                                      const CodePredicate &predicate, Sink &sink) {
+    const unsigned bitWidth = column.bitWidth, width = column.lanes;
+    const uint32_t bits = codeMask(bitWidth);
+    for (size_t block = begin / column.blockRows(); block * column.blockRows() < end; block++) {
+        const uint32_t *words = column.words.data() + block * column.blockWords();
+        size_t row = block * column.blockRows();
+        for (unsigned offset = 0; offset < 32 * bitWidth && row < end; offset += bitWidth, row += width) {
+            const uint32_t *word = words + offset / 32 * width;
+            unsigned shift = offset % 32;
+            uint64_t matches = 0;
+            NO_VECTORIZE
+            for (unsigned lane = 0; lane < width; lane++) {
+                uint64_t code = word[lane] >> shift;
+                if (shift + bitWidth > 32) code |= (uint64_t) word[lane + width] << (32 - shift);
+                matches |= (uint64_t) predicate.matches((uint32_t) code & bits) << lane;
+            }
+            if (row + width > end) matches &= (1ull << (end - row)) - 1;
+            sink(row, matches);
+        }
+    }
+    sink.finish();
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/* SSE4.2 */
+
+BEGIN_TARGET("sse4.2,popcnt")
+namespace sse {
+
+template <class T> using VecT = __m128i;
+
+template <class T>
+inline __m128i load(const T *data) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)); }
+
+inline __m128i set1(int8_t value) { return _mm_set1_epi8(value); }
+inline __m128i set1(int16_t value) { return _mm_set1_epi16(value); }
+inline __m128i set1(int32_t value) { return _mm_set1_epi32(value); }
+inline __m128i set1(int64_t value) { return _mm_set1_epi64x(value); }
+
+inline __m128i equal(__m128i a, __m128i b, int8_t) { return _mm_cmpeq_epi8(a, b); }
+inline __m128i equal(__m128i a, __m128i b, int16_t) { return _mm_cmpeq_epi16(a, b); }
+inline __m128i equal(__m128i a, __m128i b, int32_t) { return _mm_cmpeq_epi32(a, b); }
+inline __m128i equal(__m128i a, __m128i b, int64_t) { return _mm_cmpeq_epi64(a, b); }
+
+inline __m128i greater(__m128i a, __m128i b, int8_t) { return _mm_cmpgt_epi8(a, b); }
+inline __m128i greater(__m128i a, __m128i b, int16_t) { return _mm_cmpgt_epi16(a, b); }
+inline __m128i greater(__m128i a, __m128i b, int32_t) { return _mm_cmpgt_epi32(a, b); }
+inline __m128i greater(__m128i a, __m128i b, int64_t) { return _mm_cmpgt_epi64(a, b); }
+
+template <class T>
+inline __m128i outside(__m128i v, __m128i low, __m128i high, T type) {
+    return _mm_or_si128(greater(low, v, type), greater(v, high, type));
+}
+
+inline __m128i orCmp(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+
+inline uint64_t toMask(__m128i cmp, int8_t) { return (uint32_t) _mm_movemask_epi8(cmp); }
+inline uint64_t toMask(__m128i cmp, int16_t) {
+    return (uint32_t) _mm_movemask_epi8(_mm_packs_epi16(cmp, _mm_setzero_si128()));
+}
+inline uint64_t toMask(__m128i cmp, int32_t) { return (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(cmp)); }
+inline uint64_t toMask(__m128i cmp, int64_t) { return (uint32_t) _mm_movemask_pd(_mm_castsi128_pd(cmp)); }
+
+template <class T>
+inline size_t leftPack(T *out, const T *data, uint64_t mask) { return leftPackScalar(out, data, mask); }
+
+inline __m128i shiftRight32(__m128i v, unsigned n) { return _mm_srl_epi32(v, _mm_cvtsi32_si128((int) n)); }
+inline __m128i shiftLeft32(__m128i v, unsigned n) { return _mm_sll_epi32(v, _mm_cvtsi32_si128((int) n)); }
+inline __m128i and32(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+inline __m128i or32(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+inline __m128i xor32(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+
+#include "scan_kernels_simd.h"
+#include "packed_scan_simd.h"
+
+} // namespace sse
+END_TARGET
+
+/* AVX2 */
+
+BEGIN_TARGET("avx2,bmi2,popcnt")
+namespace avx2 {
+
+template <class T> using VecT = __m256i;
+
+template <class T>
+inline __m256i load(const T *data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data)); }
+
+inline __m256i set1(int8_t value) { return _mm256_set1_epi8(value); }
+inline __m256i set1(int16_t value) { return _mm256_set1_epi16(value); }
+inline __m256i set1(int32_t value) { return _mm256_set1_epi32(value); }
+inline __m256i set1(int64_t value) { return _mm256_set1_epi64x(value); }
+
+inline __m256i equal(__m256i a, __m256i b, int8_t) { return _mm256_cmpeq_epi8(a, b); }
+inline __m256i equal(__m256i a, __m256i b, int16_t) { return _mm256_cmpeq_epi16(a, b); }
+inline __m256i equal(__m256i a, __m256i b, int32_t) { return _mm256_cmpeq_epi32(a, b); }
+inline __m256i equal(__m256i a, __m256i b, int64_t) { return _mm256_cmpeq_epi64(a, b); }
+
+inline __m256i greater(__m256i a, __m256i b, int8_t) { return _mm256_cmpgt_epi8(a, b); }
+inline __m256i greater(__m256i a, __m256i b, int16_t) { return _mm256_cmpgt_epi16(a, b); }
+inline __m256i greater(__m256i a, __m256i b, int32_t) { return _mm256_cmpgt_epi32(a, b); }
+inline __m256i greater(__m256i a, __m256i b, int64_t) { return _mm256_cmpgt_epi64(a, b); }
+
+template <class T>
+inline __m256i outside(__m256i v, __m256i low, __m256i high, T type) {
+    return _mm256_or_si256(greater(low, v, type), greater(v, high, type));
+}
+
+inline __m256i orCmp(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+
+inline uint64_t toMask(__m256i cmp, int8_t) { return (uint32_t) _mm256_movemask_epi8(cmp); }
+inline uint64_t toMask(__m256i cmp, int16_t) {
+    // packs works per 128 bit lane, so pack the two halves against each other to keep element order
+    auto packed = _mm_packs_epi16(_mm256_castsi256_si128(cmp), _mm256_extracti128_si256(cmp, 1));
+    return (uint32_t) _mm_movemask_epi8(packed);
+}
+inline uint64_t toMask(__m256i cmp, int32_t) { return (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(cmp)); }
+inline uint64_t toMask(__m256i cmp, int64_t) { return (uint32_t) _mm256_movemask_pd(_mm256_castsi256_pd(cmp)); }
+
+template <class T>
+inline size_t leftPack(T *out, const T *data, uint64_t mask) { return leftPackScalar(out, data, mask); }
+
+// Left-pack of eight 32 bit lanes: pdep/pext turn the mask into the permutation indices of the selected lanes
+inline size_t leftPack32(void *out, __m256i v, uint64_t mask) {
+    uint64_t expanded = _pdep_u64(mask, 0x0101010101010101ull) * 0xFF;
+    uint64_t indices = _pext_u64(0x0706050403020100ull, expanded);
+    auto permutation = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long) indices));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_permutevar8x32_epi32(v, permutation));
+    return __builtin_popcountll(mask);
+}
+
+inline size_t leftPack(int32_t *out, const int32_t *data, uint64_t mask) {
+    return leftPack32(out, load(data), mask);
+}
+
+inline size_t leftPack(int64_t *out, const int64_t *data, uint64_t mask) {
+    // every 64 bit lane moves as a pair of 32 bit lanes
+    uint64_t pairs = _pdep_u64(mask, 0x55) | _pdep_u64(mask, 0xAA);
+    return leftPack32(out, load(data), pairs) / 2;
+}
+
+inline __m256i shiftRight32(__m256i v, unsigned n) { return _mm256_srl_epi32(v, _mm_cvtsi32_si128((int) n)); }
+inline __m256i shiftLeft32(__m256i v, unsigned n) { return _mm256_sll_epi32(v, _mm_cvtsi32_si128((int) n)); }
+inline __m256i and32(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+inline __m256i or32(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+inline __m256i xor32(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+
+#include "scan_kernels_simd.h"
+#include "packed_scan_simd.h"
+
+} // namespace avx2
+END_TARGET
+
+/* AVX-512: compares write straight into mask registers */
+
+BEGIN_TARGET("avx512f,avx512bw,popcnt")
+namespace avx512 {
+
+template <class T> using VecT = __m512i;
+
+template <class T>
+inline __m512i load(const T *data) { return _mm512_loadu_si512(data); }
+
+inline __m512i set1(int8_t value) { return _mm512_set1_epi8(value); }
+inline __m512i set1(int16_t value) { return _mm512_set1_epi16(value); }
+inline __m512i set1(int32_t value) { return _mm512_set1_epi32(value); }
+inline __m512i set1(int64_t value) { return _mm512_set1_epi64(value); }
+
+inline uint64_t equal(__m512i a, __m512i b, int8_t) { return _mm512_cmpeq_epi8_mask(a, b); }
+inline uint64_t equal(__m512i a, __m512i b, int16_t) { return _mm512_cmpeq_epi16_mask(a, b); }
+inline uint64_t equal(__m512i a, __m512i b, int32_t) { return _mm512_cmpeq_epi32_mask(a, b); }
+inline uint64_t equal(__m512i a, __m512i b, int64_t) { return _mm512_cmpeq_epi64_mask(a, b); }
+
+inline uint64_t outside(__m512i v, __m512i low, __m512i high, int8_t) {
+    return _mm512_cmplt_epi8_mask(v, low) | _mm512_cmpgt_epi8_mask(v, high);
+}
+inline uint64_t outside(__m512i v, __m512i low, __m512i high, int16_t) {
+    return _mm512_cmplt_epi16_mask(v, low) | _mm512_cmpgt_epi16_mask(v, high);
+}
+inline uint64_t outside(__m512i v, __m512i low, __m512i high, int32_t) {
+    return _mm512_cmplt_epi32_mask(v, low) | _mm512_cmpgt_epi32_mask(v, high);
+}
+inline uint64_t outside(__m512i v, __m512i low, __m512i high, int64_t) {
+    return _mm512_cmplt_epi64_mask(v, low) | _mm512_cmpgt_epi64_mask(v, high);
+}
+
+inline uint64_t orCmp(uint64_t a, uint64_t b) { return a | b; }
+
+template <class T>
+inline uint64_t toMask(uint64_t mask, T) { return mask; }
+
+// compress is only available for 8 and 16 bit lanes with VBMI2
+template <class T>
+inline size_t leftPack(T *out, const T *data, uint64_t mask) { return leftPackScalar(out, data, mask); }
+
+inline size_t leftPack(int32_t *out, const int32_t *data, uint64_t mask) {
+    _mm512_storeu_si512(out, _mm512_maskz_compress_epi32((__mmask16) mask, load(data)));
+    return __builtin_popcountll(mask);
+}
+
+inline size_t leftPack(int64_t *out, const int64_t *data, uint64_t mask) {
+    _mm512_storeu_si512(out, _mm512_maskz_compress_epi64((__mmask8) mask, load(data)));
+    return __builtin_popcountll(mask);
+}
+
+// the maskz forms avoid the undefined source operand GCC warns about
+inline __m512i shiftRight32(__m512i v, unsigned n) {
+    return _mm512_maskz_srl_epi32(0xFFFF, v, _mm_cvtsi32_si128((int) n));
+}
+inline __m512i shiftLeft32(__m512i v, unsigned n) {
+    return _mm512_maskz_sll_epi32(0xFFFF, v, _mm_cvtsi32_si128((int) n));
+}
+inline __m512i and32(__m512i a, __m512i b) { return _mm512_and_si512(a, b); }
+inline __m512i or32(__m512i a, __m512i b) { return _mm512_or_si512(a, b); }
+inline __m512i xor32(__m512i a, __m512i b) { return _mm512_xor_si512(a, b); }
+
+#include "scan_kernels_simd.h"
+#include "packed_scan_simd.h"
+
+} // namespace avx512
+END_TARGET
+
+#endif // HAVE_X86_KERNELS
+
+#ifdef HAVE_VSX_KERNELS
+
+/* VSX (POWER8) */
+
+namespace vsx {
+
+template <class T> struct VsxTypes;
+template <> struct VsxTypes<int8_t> {
+    typedef __vector signed char Vec;
+    typedef signed char Scalar;
+};
+template <> struct VsxTypes<int16_t> {
+    typedef __vector signed short Vec;
+    typedef signed short Scalar;
+};
+template <> struct VsxTypes<int32_t> {
+    typedef __vector signed int Vec;
+    typedef signed int Scalar;
+};
+template <> struct VsxTypes<int64_t> {
+    typedef __vector signed long long Vec;
+    typedef signed long long Scalar;
+};
+
+template <class T> using VecT = typename VsxTypes<T>::Vec;
+
+template <class T>
+inline VecT<T> load(const T *data) { return vec_xl(0, reinterpret_cast<const typename VsxTypes<T>::Scalar *>(data)); }
+
+template <class T>
+inline VecT<T> set1(T value) { return vec_splats((typename VsxTypes<T>::Scalar) value); }
+
+template <class T>
+inline VecT<T> equal(VecT<T> a, VecT<T> b, T) { return (VecT<T>) vec_cmpeq(a, b); }
+
+template <class T>
+inline VecT<T> outside(VecT<T> v, VecT<T> low, VecT<T> high, T) {
+    return vec_or((VecT<T>) vec_cmpgt(low, v), (VecT<T>) vec_cmpgt(v, high));
+}
+
+template <class T>
+inline VecT<T> orCmp(VecT<T> a, VecT<T> b) { return vec_or(a, b); }
+
+// There is no movemask, so every lane is weighted with its bit and the lanes are summed up.
+// Element order of the vec_* intrinsics is array order on both endiannesses.
+inline uint64_t toMask(__vector signed char cmp, int8_t) {
+    const __vector unsigned char weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    auto sums = vec_sum4s(vec_and((__vector unsigned char) cmp, weights), vec_splats(0u));
+    return (uint64_t) (vec_extract(sums, 0) + vec_extract(sums, 1)) |
+           (uint64_t) (vec_extract(sums, 2) + vec_extract(sums, 3)) << 8;
+}
+inline uint64_t toMask(__vector signed short cmp, int16_t) {
+    const __vector signed short weights = {1, 2, 4, 8, 16, 32, 64, 128};
+    auto sums = vec_sum4s(vec_and(cmp, weights), vec_splats(0));
+    return (uint64_t) (vec_extract(sums, 0) + vec_extract(sums, 1) + vec_extract(sums, 2) + vec_extract(sums, 3));
+}
+inline uint64_t toMask(__vector signed int cmp, int32_t) {
+    const __vector signed int weights = {1, 2, 4, 8};
+    auto bits = vec_and(cmp, weights);
+    return (uint64_t) (vec_extract(bits, 0) | vec_extract(bits, 1) | vec_extract(bits, 2) | vec_extract(bits, 3));
+}
+inline uint64_t toMask(__vector signed long long cmp, int64_t) {
+    return (vec_extract(cmp, 0) & 1) | (vec_extract(cmp, 1) & 2);
+}
+
+template <class T>
+inline size_t leftPack(T *out, const T *data, uint64_t mask) { return leftPackScalar(out, data, mask); }
+
+inline __vector signed int shiftRight32(__vector signed int v, unsigned n) { return vec_sr(v, vec_splats(n)); }
+inline __vector signed int shiftLeft32(__vector signed int v, unsigned n) { return vec_sl(v, vec_splats(n)); }
+inline __vector signed int and32(__vector signed int a, __vector signed int b) { return vec_and(a, b); }
+inline __vector signed int or32(__vector signed int a, __vector signed int b) { return vec_or(a, b); }
+inline __vector signed int xor32(__vector signed int a, __vector signed int b) { return vec_xor(a, b); }
+
+#include "scan_kernels_simd.h"
+#include "packed_scan_simd.h"
+
+} // namespace vsx
+
+#endif // HAVE_VSX_KERNELS
+
+/*
+ * Evaluates the predicate on rows [begin, end) of all columns, where row j of column c is columns[c][j * stride].
+ * The vector kernels need contiguous data, so strided (row store) scans always take the scalar path. The branch
+ * mode only applies to the scalar kernel, the vector kernels are branch-free by construction.
+ */
+template <class T, class Sink>
+void scanKernel(ScanKernel kernel, BranchMode mode, const T *const *columns, size_t columnCount, size_t stride,
+                size_t begin, size_t end, const Predicate<T> &predicate, Sink &sink) {
+    if (stride != 1) kernel = ScanKernel::Scalar;
+    switch (kernel) {
+#ifdef HAVE_X86_KERNELS
+        case ScanKernel::SSE: return sse::scan(columns, columnCount, begin, end, predicate, sink);
+        case ScanKernel::AVX2: return avx2::scan(columns, columnCount, begin, end, predicate, sink);
+        case ScanKernel::AVX512: return avx512::scan(columns, columnCount, begin, end, predicate, sink);
+#endif
+#ifdef HAVE_VSX_KERNELS
+        case ScanKernel::VSX: return vsx::scan(columns, columnCount, begin, end, predicate, sink);
+#endif
+        default: return scanScalar(columns, columnCount, stride, begin, end, predicate, mode, sink);
+    }
+}
+
+template <class T>
+uint64_t countMatches(ScanKernel kernel, BranchMode mode, const T *const *columns, size_t columnCount, size_t stride,
+                      size_t begin, size_t end, const Predicate<T> &predicate) {
+    CountSink sink;
+    scanKernel(kernel, mode, columns, columnCount, stride, begin, end, predicate, sink);
+    return sink.count;
+}
+
+template <class T>
+uint64_t scanValues(ScanKernel kernel, BranchMode mode, const T *const *columns, size_t columnCount, size_t stride,
+                    size_t begin, size_t end, const Predicate<T> &predicate, T *out) {
+    if (stride != 1) kernel = ScanKernel::Scalar;
+    switch (kernel) {
+#ifdef HAVE_X86_KERNELS
+        case ScanKernel::SSE: return sse::scanValues(columns, columnCount, begin, end, predicate, out);
+        case ScanKernel::AVX2: return avx2::scanValues(columns, columnCount, begin, end, predicate, out);
+        case ScanKernel::AVX512: return avx512::scanValues(columns, columnCount, begin, end, predicate, out);
+#endif
+#ifdef HAVE_VSX_KERNELS
+        case ScanKernel::VSX: return vsx::scanValues(columns, columnCount, begin, end, predicate, out);
+#endif
+        default: {
+            ScalarValueSink<T> sink(out, columns[0], stride);
+            scanScalar(columns, columnCount, stride, begin, end, predicate, mode, sink);
+            return sink.count;
+        }
+    }
+}
+
+// Runs the scan with the given output mode and returns the number of qualifying rows. *output* must hold at least
+// outputBufferBytes(mode, end - begin, sizeof(T)) bytes.
+template <class T>
+uint64_t scanInto(OutputMode output, ScanKernel kernel, BranchMode mode, const T *const *columns, size_t columnCount,
+                  size_t stride, size_t begin, size_t end, const Predicate<T> &predicate, void *buffer) {
+    switch (output) {
+        case OutputMode::Bitmap: {
+            BitmapSink sink(static_cast<uint64_t *>(buffer), begin, end);
+            scanKernel(kernel, mode, columns, columnCount, stride, begin, end, predicate, sink);
+            return sink.count;
+        }
+        case OutputMode::Positions32: {
+            PositionSink<uint32_t> sink(static_cast<uint32_t *>(buffer));
+            scanKernel(kernel, mode, columns, columnCount, stride, begin, end, predicate, sink);
+            return sink.count;
+        }
+        case OutputMode::Positions64: {
+            PositionSink<uint64_t> sink(static_cast<uint64_t *>(buffer));
+            scanKernel(kernel, mode, columns, columnCount, stride, begin, end, predicate, sink);
+            return sink.count;
+        }
+        case OutputMode::Values:
+            return scanValues(kernel, mode, columns, columnCount, stride, begin, end, predicate,
+                              static_cast<T *>(buffer));
+        default:
+            return countMatches(kernel, mode, columns, columnCount, stride, begin, end, predicate);
+    }
+}
+
+// Number of 32 bit lanes a vertically packed column needs for *kernel*
+inline unsigned packedLanes(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::AVX512: return 16;
+        case ScanKernel::AVX2: return 8;
+        default: return 4;
+    }
+}
+
+/*
+ * Evaluates the predicate on the packed codes of rows [begin, end) without decompressing them. Horizontally packed
+ * columns and columns packed for a different vector width are scanned by the scalar kernel. Vertically packed scans
+ * must start on a block boundary.
+ */
+template <class Sink>
+void scanPackedKernel(ScanKernel kernel, BranchMode mode, const PackedColumn &column, size_t begin, size_t end,
+                      const CodePredicate &predicate, Sink &sink) {
+    if (column.packing == Packing::Horizontal) {
+        if (predicate.isList()) {
+            scanHorizontalScalar(column, begin, end, CodeMatch{predicate}, mode, sink);
+        } else {
+            scanHorizontalScalar(column, begin, end, BetweenMatch<uint32_t>{predicate.low, predicate.high}, mode,
+                                 sink);
+        }
+        return;
+    }
+    if (column.lanes != packedLanes(kernel)) kernel = ScanKernel::Scalar;
+    switch (kernel) {
+#ifdef HAVE_X86_KERNELS
+        case ScanKernel::SSE: return sse::scanPacked(column, begin, end, predicate, sink);
+        case ScanKernel::AVX2: return avx2::scanPacked(column, begin, end, predicate, sink);
+        case ScanKernel::AVX512: return avx512::scanPacked(column, begin, end, predicate, sink);
+#endif
+#ifdef HAVE_VSX_KERNELS
+        case ScanKernel::VSX: return vsx::scanPacked(column, begin, end, predicate, sink);
+#endif
+        default: return scanVerticalScalar(column, begin, end, predicate, sink);
+    }
+}
+
+// Like scanInto() for packed columns. Only count, bitmap and positions are supported, there are no values to copy.
+inline uint64_t scanPackedInto(OutputMode output, ScanKernel kernel, BranchMode mode, const PackedColumn &column,
+                               size_t begin, size_t end, const CodePredicate &predicate, void *buffer) {
+    switch (output) {
+        case OutputMode::Bitmap: {
+            BitmapSink sink(static_cast<uint64_t *>(buffer), begin, end);
+            scanPackedKernel(kernel, mode, column, begin, end, predicate, sink);
+            return sink.count;
+        }
+        case OutputMode::Positions32: {
+            PositionSink<uint32_t> sink(static_cast<uint32_t *>(buffer));
+            scanPackedKernel(kernel, mode, column, begin, end, predicate, sink);
+            return sink.count;
+        }
+        case OutputMode::Positions64: {
+            PositionSink<uint64_t> sink(static_cast<uint64_t *>(buffer));
+            scanPackedKernel(kernel, mode, column, begin, end, predicate, sink);
+            return sink.count;
+        }
+        default: {
+            CountSink sink;
+            scanPackedKernel(kernel, mode, column, begin, end, predicate, sink);
+            return sink.count;
+        }
+    }
+}
+
+#endif // SCAN_KERNELS_H
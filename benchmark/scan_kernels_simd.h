@@ -0,0 +1,169 @@
+/*
+ * Instruction set independent part of the vector scan kernels.
+ *
+ * This file intentionally has no include guard: scan_kernels.h includes it once per instruction set, inside a
+ * namespace that is compiled for that instruction set and provides
+ *   VecT<T>                          vector register type holding elements of type T
+ *   load(const T *)                  unaligned load of one vector
+ *   set1(T)                          broadcast
+ *   equal(v, w, T), outside(v, low, high, T), orCmp(a, b)   comparisons
+ *   toMask(cmp, T)                   one bit per lane, lane i in bit i
+ *   leftPack(out, data, mask)        writes the lanes selected by mask to out, returns their number
+ */
+
+template <class T>
+static inline constexpr size_t lanes() {
+    return sizeof(VecT<T>) / sizeof(T);
+}
+
+template <class T>
+static inline uint64_t allLanes() {
+    return lanes<T>() == 64 ? ~0ull : (1ull << lanes<T>()) - 1;
+}
+
+// Each functor returns the match bitmask of the lanes<T>() elements starting at data
+
+template <class T>
+struct EqualMask {
+    explicit EqualMask(const Predicate<T> &predicate) : predicate(predicate), needle(set1(predicate.low)) {}
+
+    inline uint64_t operator()(const T *data) const {
+        return toMask(equal(load(data), needle, T()), T());
+    }
+
+    const Predicate<T> &predicate;
+    VecT<T> needle;
+};
+
+template <class T>
+struct BetweenMask {
+    explicit BetweenMask(const Predicate<T> &predicate)
+            : predicate(predicate), low(set1(predicate.low)), high(set1(predicate.high)) {}
+
+    inline uint64_t operator()(const T *data) const {
+        return ~toMask(outside(load(data), low, high, T()), T()) & allLanes<T>();
+    }
+
+    const Predicate<T> &predicate;
+    VecT<T> low;
+    VecT<T> high;
+};
+
+template <class T>
+struct InListMask {
+    explicit InListMask(const Predicate<T> &predicate) : predicate(predicate), count(predicate.values.size()) {
+        for (size_t i = 0; i < count; i++) needles[i] = set1(predicate.values[i]);
+    }
+
+    inline uint64_t operator()(const T *data) const {
+        auto v = load(data);
+        auto cmp = equal(v, needles[0], T());
+        for (size_t i = 1; i < count; i++) cmp = orCmp(cmp, equal(v, needles[i], T()));
+        return toMask(cmp, T());
+    }
+
+    const Predicate<T> &predicate;
+    size_t count;
+    VecT<T> needles[SIMD_IN_LIST_LIMIT];
+};
+
+// Large IN-lists probe the bitmap or hash set lane by lane
+template <class T>
+struct LookupMask {
+    explicit LookupMask(const Predicate<T> &predicate) : predicate(predicate) {}
+
+    inline uint64_t operator()(const T *data) const {
+        uint64_t mask = 0;
+        for (size_t lane = 0; lane < lanes<T>(); lane++) {
+            mask |= (uint64_t) predicate.lookup(data[lane]) << lane;
+        }
+        return mask;
+    }
+
+    const Predicate<T> &predicate;
+};
+
+template <class T, class Mask, class Sink>
+void scanColumns(const T *const *columns, size_t columnCount, size_t begin, size_t end, const Mask &mask,
+                 Sink &sink) {
+    size_t j = begin;
+    if (columnCount == 1) {
+        const T *column = columns[0];
+        for (; j + lanes<T>() <= end; j += lanes<T>()) {
+            sink(j, mask(column + j));
+        }
+    } else {
+        // the conjunction is evaluated column at a time and without branches
+        for (; j + lanes<T>() <= end; j += lanes<T>()) {
+            uint64_t matches = mask(columns[0] + j);
+            for (size_t c = 1; c < columnCount; c++) {
+                matches &= mask(columns[c] + j);
+            }
+            sink(j, matches);
+        }
+    }
+    if (j < end) {
+        uint64_t matches = 0;
+        for (size_t k = j; k < end; k++) {
+            bool match = true;
+            for (size_t c = 0; c < columnCount; c++) match &= mask.predicate.matches(columns[c][k]);
+            matches |= (uint64_t) match << (k - j);
+        }
+        sink(j, matches);
+    }
+    sink.finish();
+}
+
+// Calls sink(index, mask) for every block of lanes<T>() rows starting at index, bit i of mask is set if row
+// index + i satisfies the predicate on all columns
+template <class T, class Sink>
+void scan(const T *const *columns, size_t columnCount, size_t begin, size_t end, const Predicate<T> &predicate,
+          Sink &sink) {
+    if (predicate.usesLookup()) {
+        scanColumns(columns, columnCount, begin, end, LookupMask<T>(predicate), sink);
+        return;
+    }
+    switch (predicate.type()) {
+        case PredicateType::Equal:
+            scanColumns(columns, columnCount, begin, end, EqualMask<T>(predicate), sink);
+            break;
+        case PredicateType::Between:
+            scanColumns(columns, columnCount, begin, end, BetweenMask<T>(predicate), sink);
+            break;
+        case PredicateType::InList:
+            scanColumns(columns, columnCount, begin, end, InListMask<T>(predicate), sink);
+            break;
+    }
+}
+
+// Writes the values of the qualifying rows of the first column with this instruction set's left-pack
+template <class T>
+struct ValueSink {
+    ValueSink(T *out, const T *column, size_t end) : out(out), column(column), end(end) {}
+
+    inline void operator()(size_t index, uint64_t mask) {
+        if (index + lanes<T>() <= end) {
+            count += leftPack(out + count, column + index, mask);
+        } else {
+            // the tail block must not load past the end of the column
+            while (mask) {
+                out[count++] = column[index + __builtin_ctzll(mask)];
+                mask &= mask - 1;
+            }
+        }
+    }
+    inline void finish() {}
+
+    T *out;
+    const T *column;
+    size_t end;
+    uint64_t count = 0;
+};
+
+template <class T>
+uint64_t scanValues(const T *const *columns, size_t columnCount, size_t begin, size_t end,
+                    const Predicate<T> &predicate, T *out) {
+    ValueSink<T> sink(out, columns[0], end);
+    scan(columns, columnCount, begin, end, predicate, sink);
+    return sink.count;
+}
@@ -0,0 +1,114 @@
+#ifndef SIZE_SWEEP_H
+#define SIZE_SWEEP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cache_control.h"
+
+/*
+ * Sizes a run is measured at, generated from the caches of the CPUs the threads run on.
+ *
+ * The sweep is log-spaced from the minimum to the maximum size, plus points around every cache boundary: from half to
+ * twice the capacity of a level, densest near the capacity itself. The capacity of a level is that of all its caches
+ * the threads can use, so a per-core L2 counts once per core the threads run on and a shared L3 once per socket. A
+ * size is that of the whole table, or of one thread for per-thread working sets, whose capacities are divided by the
+ * thread count.
+ */
+
+static const size_t KiB = 1024;
+static const size_t MiB = 1024 * KiB;
+static const size_t GiB = 1024 * MiB;
+
+// Relative to a cache capacity
+static const double BOUNDARY_POINTS[] = {0.5, 0.75, 0.9, 1.0, 1.1, 1.25, 1.5, 2.0};
+
+// Accepts bytes with an optional K, M or G suffix, e.g. 48K or 4G
+inline bool parseByteSize(const std::string &text, size_t &bytes) {
+    char *unit;
+    unsigned long long value = strtoull(text.c_str(), &unit, 10);
+    if (text.empty() || unit == text.c_str()) return false;
+    std::string suffix(unit);
+    if (suffix == "K" || suffix == "k") value *= KiB;
+    else if (suffix == "M" || suffix == "m") value *= MiB;
+    else if (suffix == "G" || suffix == "g") value *= GiB;
+    else if (!suffix.empty()) return false;
+    bytes = (size_t) value;
+    return true;
+}
+
+// e.g. 48 KiB or 105 MiB
+inline std::string byteSizeLabel(size_t bytes) {
+    if (bytes >= GiB && bytes % GiB == 0) return std::to_string(bytes / GiB) + " GiB";
+    if (bytes >= MiB && bytes % MiB == 0) return std::to_string(bytes / MiB) + " MiB";
+    if (bytes >= KiB && bytes % KiB == 0) return std::to_string(bytes / KiB) + " KiB";
+    return std::to_string(bytes) + " B";
+}
+
+// The data and unified caches of one level that the threads of a pool use
+struct CacheCapacity {
+    int level;
+    size_t bytes; // of one cache
+    int instances; // distinct caches of the level among the CPUs of the pool
+    int sharingCpus; // online CPUs that share one cache
+};
+
+// Levels in ascending order, empty if sysfs does not describe the caches
+inline std::vector<CacheCapacity> poolCacheCapacities(const std::vector<int> &poolCpus) {
+    // the CPUs that share a cache identify it
+    std::map<int, std::map<std::vector<int>, size_t>> levels;
+    for (auto cpu: poolCpus) {
+        for (auto &cache: cpuCaches(cpu)) levels[cache.level][cache.sharedCpus] = cache.bytes;
+    }
+    std::vector<CacheCapacity> capacities;
+    for (auto &level: levels) {
+        // e.g. an L3 split into differently sized slices would report the largest
+        size_t bytes = 0;
+        int sharing = 0;
+        for (auto &cache: level.second) {
+            bytes = std::max(bytes, cache.second);
+            sharing = std::max(sharing, (int) cache.first.size());
+        }
+        capacities.push_back({level.first, bytes, (int) level.second.size(), sharing});
+    }
+    return capacities;
+}
+
+struct SweepOptions {
+    size_t minSize;
+    size_t maxSize;
+    int points; // log-spaced ones between minSize and maxSize
+};
+
+/*
+ * Sizes in ascending order, multiples of 1 KiB. *perThread* sizes are working sets of single threads, out of
+ * *threadCount*.
+ */
+inline std::vector<size_t> sweepSizes(const SweepOptions &options, const std::vector<CacheCapacity> &caches,
+                                      int threadCount, bool perThread) {
+    std::vector<double> sizes;
+    double ratio = options.points > 1 ? std::pow((double) options.maxSize / options.minSize, 1.0 / (options.points - 1))
+                                      : 1;
+    for (int p = 0; p < options.points; p++) sizes.push_back(options.minSize * std::pow(ratio, p));
+    for (auto &cache: caches) {
+        double capacity = (double) cache.bytes * cache.instances / (perThread ? threadCount : 1);
+        for (auto factor: BOUNDARY_POINTS) sizes.push_back(capacity * factor);
+    }
+
+    std::vector<size_t> result;
+    for (auto size: sizes) {
+        auto rounded = std::max<size_t>(1, (size_t) std::llround(size / KiB)) * KiB;
+        if (rounded >= options.minSize && rounded <= options.maxSize) result.push_back(rounded);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+#endif // SIZE_SWEEP_H
@@ -0,0 +1,74 @@
+#ifndef SOFTWARE_PREFETCH_H
+#define SOFTWARE_PREFETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "column_memory.h"
+
+/*
+ * Kernels that prefetch explicitly, a fixed distance ahead of the loads.
+ *
+ *   scan    sums a column, prefetching the cache line *distance* lines ahead once per line. The hardware prefetchers
+ *           recognize this stream easily, so prefetching only pays off if they are switched off or cannot keep up.
+ *   gather  sums the values at a list of random positions, prefetching the value *distance* positions ahead. The
+ *           hardware prefetchers cannot predict these addresses, only the position list itself is a stream.
+ *
+ * A distance of 0 issues no prefetches, it is the baseline of the other distances.
+ */
+
+enum class AccessPattern { Scan, Gather };
+
+inline bool parseAccessPattern(const std::string &name, AccessPattern &access) {
+    if (name == "scan") access = AccessPattern::Scan;
+    else if (name == "gather") access = AccessPattern::Gather;
+    else return false;
+    return true;
+}
+
+inline std::string accessPatternName(AccessPattern access) {
+    return access == AccessPattern::Scan ? "scan" : "gather";
+}
+
+// Fetches the cache line of *address* into all cache levels for reading, dcbt on POWER
+inline void prefetchLine(const void *address) {
+#ifdef _ARCH_PPC64
+    __asm__ __volatile__("dcbt 0,%0" : : "r"(address) : "memory");
+#else
+    __builtin_prefetch(address, 0, 3);
+#endif
+}
+
+// Sums rows [begin, end), *begin* starts a cache line. The last *distance* lines have nothing left to prefetch.
+template <class T>
+uint64_t scanPrefetched(const T *column, size_t begin, size_t end, size_t distance) {
+    const size_t lineValues = CACHE_LINE_BYTES / sizeof(T), ahead = distance * lineValues;
+    uint64_t sum = 0;
+    size_t i = begin;
+    if (distance > 0) {
+        for (; i + ahead + lineValues <= end; i += lineValues) {
+            prefetchLine(column + i + ahead);
+            for (size_t k = 0; k < lineValues; k++) sum += column[i + k];
+        }
+    }
+    for (; i < end; i++) sum += column[i];
+    return sum;
+}
+
+// Sums the values at positions[begin, end)
+template <class T>
+uint64_t gatherPrefetched(const T *column, const uint32_t *positions, size_t begin, size_t end, size_t distance) {
+    uint64_t sum = 0;
+    size_t i = begin;
+    if (distance > 0) {
+        for (; i + distance < end; i++) {
+            prefetchLine(column + positions[i + distance]);
+            sum += column[positions[i]];
+        }
+    }
+    for (; i < end; i++) sum += column[positions[i]];
+    return sum;
+}
+
+#endif // SOFTWARE_PREFETCH_H
@@ -0,0 +1,185 @@
+#ifndef TABLE_LAYOUT_H
+#define TABLE_LAYOUT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "column_memory.h"
+#include "predicate.h"
+#include "scan_kernels.h"
+
+/*
+ * Tables of attributes of different widths, stored in one of three layouts:
+ *   nsm  rows one after another, the attributes of a row next to each other (row store)
+ *   dsm  one column per attribute (column store)
+ *   pax  row groups, each holding a mini column per attribute for its rows
+ * Attributes are 8, 16, 32 or 64 bit integers. NSM aligns every attribute to its width and pads the row to the widest
+ * one, DSM columns and PAX mini columns start on a cache line.
+ */
+
+enum class Layout { NSM, DSM, PAX };
+
+inline bool parseLayout(const std::string &name, Layout &layout) {
+    if (name == "nsm") layout = Layout::NSM;
+    else if (name == "dsm") layout = Layout::DSM;
+    else if (name == "pax") layout = Layout::PAX;
+    else return false;
+    return true;
+}
+
+inline std::string layoutName(Layout layout) {
+    switch (layout) {
+        case Layout::NSM: return "NSM";
+        case Layout::DSM: return "DSM";
+        case Layout::PAX: return "PAX";
+    }
+    return "unknown";
+}
+
+class TableLayout {
+public:
+    // *widths* in bytes, *groupRows* only applies to PAX
+    TableLayout(Layout layout, const std::vector<unsigned> &widths, size_t rows, size_t groupRows)
+            : layout(layout), widths(widths), rows(rows),
+              groupSize(layout == Layout::PAX ? groupRows : std::max<size_t>(1, rows)) {
+        size_t offset = 0, widest = 1;
+        for (auto width: widths) {
+            if (layout == Layout::NSM) {
+                offset = alignUp(offset, width);
+                offsets.push_back(offset);
+                offset += width;
+            } else {
+                offsets.push_back(offset);
+                offset += alignUp(groupSize * width, CACHE_LINE_BYTES);
+            }
+            widest = std::max<size_t>(widest, width);
+        }
+        // an NSM group is a single row
+        groupBytes = layout == Layout::NSM ? alignUp(offset, widest) : offset;
+    }
+
+    // Rows after which the attributes continue somewhere else, scans do not cross them
+    size_t groupRows() const { return layout == Layout::NSM ? rows : groupSize; }
+
+    size_t bytes() const {
+        if (layout == Layout::NSM) return rows * groupBytes;
+        return (rows + groupSize - 1) / groupSize * groupBytes;
+    }
+
+    int attributes() const { return (int) widths.size(); }
+    unsigned width(int attribute) const { return widths[attribute]; }
+
+    // Bytes from one row of an attribute to the next inside a group
+    size_t stride(int attribute) const { return layout == Layout::NSM ? groupBytes : widths[attribute]; }
+
+    size_t offset(size_t row, int attribute) const {
+        if (layout == Layout::NSM) return row * groupBytes + offsets[attribute];
+        return row / groupSize * groupBytes + offsets[attribute] + row % groupSize * widths[attribute];
+    }
+
+    const Layout layout;
+    const std::vector<unsigned> widths;
+    const size_t rows;
+
+private:
+    size_t groupSize;
+    size_t groupBytes;
+    std::vector<size_t> offsets;
+};
+
+// Predicates of the scanned attributes, one per attribute type
+struct TablePredicates {
+    Predicate<int8_t> int8;
+    Predicate<int16_t> int16;
+    Predicate<int32_t> int32;
+    Predicate<int64_t> int64;
+};
+
+// Rows a table scan evaluates at once, their match flags stay in the L1 cache
+static const size_t TABLE_CHUNK_ROWS = 1024;
+
+/*
+ * Clears the flags of the rows whose value does not match. *Stride* is the distance between two values when it is
+ * known at compile time, and 0 if it is only known at runtime.
+ */
+template <class T, size_t Stride, class Match>
+SCALAR_KERNEL void matchAttribute(const char *data, size_t stride, size_t rows, const Match &match, uint8_t *flags) {
+    const size_t step = Stride ? Stride : stride;
+    NO_VECTORIZE
+    for (size_t j = 0; j < rows; j++) {
+        T value;
+        memcpy(&value, data + j * step, sizeof(T));
+        flags[j] &= match(value);
+    }
+}
+
+// Picks the compile-time stride for rows of up to Multiple values of T, larger strides are runtime ones
+template <class T, class Match, size_t Multiple = 16>
+struct StrideDispatch {
+    static void match(const char *data, size_t stride, size_t rows, const Match &match, uint8_t *flags) {
+        if (stride == Multiple * sizeof(T)) {
+            matchAttribute<T, Multiple * sizeof(T)>(data, stride, rows, match, flags);
+        } else {
+            StrideDispatch<T, Match, Multiple - 1>::match(data, stride, rows, match, flags);
+        }
+    }
+};
+
+template <class T, class Match>
+struct StrideDispatch<T, Match, 0> {
+    static void match(const char *data, size_t stride, size_t rows, const Match &match, uint8_t *flags) {
+        matchAttribute<T, 0>(data, stride, rows, match, flags);
+    }
+};
+
+template <class T>
+void matchAttribute(const char *data, size_t stride, size_t rows, const Predicate<T> &predicate, uint8_t *flags) {
+    switch (predicate.type()) {
+        case PredicateType::Equal:
+            StrideDispatch<T, EqualMatch<T>>::match(data, stride, rows, EqualMatch<T>{predicate.low}, flags);
+            break;
+        case PredicateType::Between:
+            StrideDispatch<T, BetweenMatch<T>>::match(data, stride, rows,
+                                                      BetweenMatch<T>{predicate.low, predicate.high}, flags);
+            break;
+        case PredicateType::InList:
+            StrideDispatch<T, LookupMatch<T>>::match(data, stride, rows, LookupMatch<T>{predicate}, flags);
+            break;
+    }
+}
+
+/*
+ * Counts the rows of [begin, end) whose first *attributes* attributes all satisfy their predicate. The rows are
+ * evaluated a chunk and an attribute at a time, so every layout runs the same code and only differs in the strides.
+ */
+SCALAR_KERNEL inline uint64_t scanTable(const char *table, const TableLayout &layout, int attributes, size_t begin,
+                                        size_t end, const TablePredicates &predicates) {
+    uint8_t flags[TABLE_CHUNK_ROWS];
+    uint64_t count = 0;
+    const size_t groupRows = layout.groupRows();
+    for (size_t chunk = begin; chunk < end;) {
+        size_t rows = std::min(std::min(end - chunk, TABLE_CHUNK_ROWS), groupRows - chunk % groupRows);
+        memset(flags, 1, rows);
+        for (int a = 0; a < attributes; a++) {
+            const char *data = table + layout.offset(chunk, a);
+            size_t stride = layout.stride(a);
+            switch (layout.width(a)) {
+                case 1: matchAttribute(data, stride, rows, predicates.int8, flags); break;
+                case 2: matchAttribute(data, stride, rows, predicates.int16, flags); break;
+                case 4: matchAttribute(data, stride, rows, predicates.int32, flags); break;
+                default: matchAttribute(data, stride, rows, predicates.int64, flags); break;
+            }
+        }
+        NO_VECTORIZE
+        for (size_t j = 0; j < rows; j++) count += flags[j];
+        chunk += rows;
+    }
+    return count;
+}
+
+#endif // TABLE_LAYOUT_H
@@ -0,0 +1,160 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Persistent, pinned benchmark threads.
+ *
+ * The workers are started once and pinned to one CPU each, so neither thread creation nor migrations end up in the
+ * measurements. Waiting is done with a short spin followed by a futex, which keeps idle workers from stealing cycles
+ * from their SMT siblings.
+ */
+
+inline void futexWait(std::atomic<uint32_t> &word, uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void futexWakeAll(std::atomic<uint32_t> &word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Waits until *word* differs from *value*
+inline void waitWhileEqual(std::atomic<uint32_t> &word, uint32_t value) {
+    for (int spin = 0; spin < 4096; spin++) {
+        if (word.load(std::memory_order_acquire) != value) return;
+    }
+    while (word.load(std::memory_order_acquire) == value) futexWait(word, value);
+}
+
+// Reusable barrier for a fixed number of threads
+class Barrier {
+public:
+    explicit Barrier(uint32_t threadCount) : threadCount(threadCount) {}
+
+    void wait() {
+        uint32_t current = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == threadCount) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            futexWakeAll(generation);
+        } else {
+            waitWhileEqual(generation, current);
+        }
+    }
+
+private:
+    const uint32_t threadCount;
+    std::atomic<uint32_t> arrived{0};
+    std::atomic<uint32_t> generation{0};
+};
+
+/*
+ * Parses a CPU list like "0-14,120-134". An empty list means the CPUs the process may run on, which also respects
+ * taskset and numactl --cpunodebind.
+ */
+inline bool parseCpuList(const std::string &list, std::vector<int> &cpus) {
+    cpus.clear();
+    if (list.empty()) {
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+        return !cpus.empty();
+    }
+    size_t position = 0;
+    while (position <= list.size()) {
+        size_t next = list.find(',', position);
+        if (next == std::string::npos) next = list.size();
+        auto range = list.substr(position, next - position);
+        char *end;
+        long first = strtol(range.c_str(), &end, 10), last = first;
+        if (*end == '-' && isdigit(end[1])) last = strtol(end + 1, &end, 10);
+        if (range.empty() || *end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) return false;
+        for (long cpu = first; cpu <= last; cpu++) cpus.push_back((int) cpu);
+        position = next + 1;
+    }
+    return true;
+}
+
+class WorkerPool {
+public:
+    // Worker i is pinned to cpus[i % cpus.size()]
+    WorkerPool(int threadCount, const std::vector<int> &cpus) : startBarrier(threadCount) {
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back(&WorkerPool::work, this, i);
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[i % cpus.size()], &set);
+            pinned &= pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set) == 0;
+            workerCpus.push_back(cpus[i % cpus.size()]);
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool() {
+        run(nullptr);
+        for (auto &thread: threads) thread.join();
+    }
+
+    int size() const { return (int) threads.size(); }
+
+    // CPU of every worker
+    const std::vector<int> &cpus() const { return workerCpus; }
+
+    // False if a worker could not be pinned to its CPU, e.g. because the CPU is not available to the process
+    bool allPinned() const { return pinned; }
+
+    // Runs task(threadId) on every worker and returns once all of them are done
+    void run(std::function<void(int)> task) {
+        this->task = std::move(task);
+        pending.store(threads.size(), std::memory_order_relaxed);
+        epoch.fetch_add(1, std::memory_order_release);
+        futexWakeAll(epoch);
+        uint32_t left;
+        while ((left = pending.load(std::memory_order_acquire)) != 0) waitWhileEqual(pending, left);
+    }
+
+    // Lets all workers of the current task start the next timed region together
+    void barrier() { startBarrier.wait(); }
+
+private:
+    void work(int threadId) {
+        uint32_t seen = 0;
+        while (true) {
+            waitWhileEqual(epoch, seen);
+            seen = epoch.load(std::memory_order_acquire);
+            bool stop = !task;
+            if (!stop) task(threadId);
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) futexWakeAll(pending);
+            if (stop) return;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> workerCpus;
+    std::function<void(int)> task;
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> pending{0};
+    Barrier startBarrier;
+    bool pinned = true;
+};
+
+#endif // WORKER_POOL_H
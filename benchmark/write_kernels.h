@@ -0,0 +1,176 @@
+#ifndef WRITE_KERNELS_H
+#define WRITE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "column_memory.h"
+#include "data_generator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Kernels of the write path.
+ *
+ *   fill    writes a column front to back with ordinary stores. Every line is read before it is written (read for
+ *           ownership), so memory sees twice the bytes the kernel writes.
+ *   stream  writes the same values with stores that skip the read for ownership: non-temporal stores on x86, which
+ *           bypass the caches, and dcbz on POWER, which claims a zeroed cache line without reading it.
+ *   update  adds 1 to random rows in place, every update reads and writes a line.
+ *   append  copies rows into a delta buffer that is reserved up front, as the delta of a delta/main store.
+ *
+ * fill and stream store 16 byte vectors of the same values, so they only differ in the kind of store.
+ */
+
+enum class WriteKind { Fill, Stream, Update, Append };
+
+inline bool parseWriteKind(const std::string &name, WriteKind &kind) {
+    if (name == "fill") kind = WriteKind::Fill;
+    else if (name == "stream") kind = WriteKind::Stream;
+    else if (name == "update") kind = WriteKind::Update;
+    else if (name == "append") kind = WriteKind::Append;
+    else return false;
+    return true;
+}
+
+inline std::string writeKindName(WriteKind kind) {
+    switch (kind) {
+        case WriteKind::Fill: return "fill";
+        case WriteKind::Stream: return "stream";
+        case WriteKind::Update: return "update";
+        case WriteKind::Append: return "append";
+    }
+    return "unknown";
+}
+
+#ifdef _ARCH_PPC64
+// dcbz zeroes a whole POWER cache line
+static const size_t WRITE_BLOCK_BYTES = 128;
+#else
+static const size_t WRITE_BLOCK_BYTES = CACHE_LINE_BYTES;
+#endif
+
+static const size_t STORE_BYTES = 16;
+
+template <class T>
+struct StoreVector {
+    typedef T type __attribute__((vector_size(STORE_BYTES)));
+};
+
+// base, base + 1, ... in the lanes of a vector
+template <class T>
+inline typename StoreVector<T>::type countingVector(T base) {
+    typename StoreVector<T>::type v;
+    for (size_t l = 0; l < STORE_BYTES / sizeof(T); l++) v[l] = (T) (base + l);
+    return v;
+}
+
+// Writes base, base + 1, ... to rows [begin, end), *begin* starts a WRITE_BLOCK_BYTES block
+template <class T>
+void fillColumn(T *column, size_t begin, size_t end, T base) {
+    typedef typename StoreVector<T>::type V;
+    const size_t lanes = STORE_BYTES / sizeof(T);
+    V v = countingVector(base), step = V{} + (T) lanes;
+    size_t i = begin;
+    for (; i + lanes <= end; i += lanes) {
+        *reinterpret_cast<V *>(column + i) = v;
+        v += step;
+    }
+    for (; i < end; i++) column[i] = (T) (base + (i - begin));
+}
+
+// Writes the same values as fillColumn() without reading the lines first. The column starts on a page.
+template <class T>
+void streamColumn(T *column, size_t begin, size_t end, T base) {
+    typedef typename StoreVector<T>::type V;
+    const size_t lanes = STORE_BYTES / sizeof(T);
+    V v = countingVector(base), step = V{} + (T) lanes;
+    size_t i = begin;
+#if defined(__x86_64__) || defined(__i386__)
+    for (; i + lanes <= end; i += lanes) {
+        _mm_stream_si128(reinterpret_cast<__m128i *>(column + i), (__m128i) v);
+        v += step;
+    }
+    // non-temporal stores are weakly ordered, they have to be visible before the run counts as done
+    _mm_sfence();
+#elif defined(_ARCH_PPC64)
+    const size_t blockRows = WRITE_BLOCK_BYTES / sizeof(T);
+    for (; i + blockRows <= end; i += blockRows) {
+        __asm__ __volatile__("dcbz 0,%0" : : "r"(column + i) : "memory");
+        for (size_t k = 0; k < blockRows; k += lanes) {
+            *reinterpret_cast<V *>(column + i + k) = v;
+            v += step;
+        }
+    }
+#endif
+    for (; i < end; i++) column[i] = (T) (base + (i - begin));
+}
+
+// Adds 1 to the rows at positions[begin, end)
+template <class T>
+void updateColumn(T *column, const uint32_t *positions, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) column[positions[i]] += 1;
+}
+
+// Stores of the writers of the mixed workload: atomic read-modify-writes (lock add on x86) or plain ones
+enum class WriterStores { Atomic, Plain };
+
+inline bool parseWriterStores(const std::string &name, WriterStores &stores) {
+    if (name == "atomic") stores = WriterStores::Atomic;
+    else if (name == "plain") stores = WriterStores::Plain;
+    else return false;
+    return true;
+}
+
+inline std::string writerStoresName(WriterStores stores) {
+    return stores == WriterStores::Atomic ? "atomic" : "plain";
+}
+
+// Updates between two checks whether a writer should stop
+static const int WRITER_BATCH = 64;
+
+// Adds 1 to random rows of a column until stop() returns true, returns the number of updates
+
+template <WriterStores Stores, class T, class Stop>
+uint64_t updateRandomRows(T *column, size_t rows, CounterRng &generator, Stop stop) {
+    uint64_t updates = 0;
+    do {
+        for (int u = 0; u < WRITER_BATCH; u++) {
+            T *row = column + (size_t) (((unsigned __int128) generator() * rows) >> 64);
+            if (Stores == WriterStores::Atomic) __atomic_fetch_add(row, 1, __ATOMIC_RELAXED);
+            else *row += 1;
+        }
+        updates += WRITER_BATCH;
+    } while (!stop());
+    return updates;
+}
+
+// Appended values with the rows of the main store they belong to, *capacity* of them are reserved
+template <class T>
+struct DeltaBuffer {
+    T *values;
+    uint32_t *rows;
+    size_t size;
+    size_t capacity;
+
+    inline bool append(T value, uint32_t row) {
+        if (size == capacity) return false;
+        values[size] = value;
+        rows[size] = row;
+        size++;
+        return true;
+    }
+};
+
+// Appends rows [begin, end) of *column* to *delta*, returns the number of rows that fit
+template <class T>
+uint64_t appendRows(const T *column, size_t begin, size_t end, DeltaBuffer<T> &delta) {
+    uint64_t appended = 0;
+    for (size_t i = begin; i < end; i++) appended += delta.append(column[i], (uint32_t) i);
+    return appended;
+}
+
+#endif // WRITE_KERNELS_H
@@ -17,6 +17,22 @@ tkey = 'Time in ns'
 colszkey = 'Column size in KB'  # These are actually KiB.
 dtypekey = 'Data type'
 threads_key = 'Thread Count'
+selectivity_key = 'Selectivity'  # measured on the data, depends on the column size
+write_time_key = 'Write time in ns'
+output_bytes_key = 'Output bytes'
+rows_key = 'Rows'  # bit-packed columns hold more rows than their size suggests
+tuples_key = 'Tuples per second'
+bytes_key = 'Bytes per second'
+# summary of all samples of a table, repeated on each of its rows
+summary_keys = {'Median time in ns', 'P5 time in ns', 'P95 time in ns', 'Stddev time in ns', 'Samples'}
+# busy times of the threads of a sample, which tell the load imbalance
+thread_time_keys = {'Makespan in ns', 'Max thread time in ns', 'Min thread time in ns'}
+# bound of a scan from --roofline, which changes with the column size
+roofline_keys = {'Roofline limit', 'Roofline bytes per second', 'Fraction of roofline'}
+counter_prefix = 'Counter '  # one column per hardware counter, e.g. 'Counter cycles'
+# Columns that hold measurements rather than configuration and must not be used to group the curves
+measurement_keys = {tkey, colszkey, selectivity_key, write_time_key, output_bytes_key, rows_key, tuples_key,
+                    bytes_key} | summary_keys | thread_time_keys | roofline_keys
 colors = ['#af0039', '#007a9e', '#dd630d', '#f6a800']
 linestyles = ['-', '--']
 red = '#af0039'
@@ -43,7 +59,8 @@ def process_file(filename, show_variance, only_64, system_type, ylim, multicore,
     ax.spines['right'].set_visible(False)
 
     dtype_cols = []
-    for column in set(data.columns) - {tkey, colszkey}:
+    counter_keys = {column for column in data.columns if column.startswith(counter_prefix)}
+    for column in set(data.columns) - measurement_keys - counter_keys:
         if len(np.unique(data[column])) > 1:
             dtype_cols.append(column)
 
@@ -55,6 +55,15 @@ for PREFETCH_SET in "${PREFETCHER_SETTINGS[@]}"; do
     fi
   fi  
 
+  # load-to-use latency with 1..16 independent chains, single-threaded
+  FILENAME=latency-prefetch"$PREFETCH_SET"-smt1-thread1
+  if $IS_POWER; then
+    ppc64_cpu --smt=1
+    numactl --cpunodebind=$CPUNODE benchmark/benchmark --mode latency --placement node --memory-node $MEMNODE --thread-count 1 > $FOLDER/$FILENAME.csv
+  else
+    benchmark/benchmark --mode latency --cpus "${CORE_BINDINGS[0]}" --placement node --memory-node $MEMNODE --thread-count 1 > $FOLDER/$FILENAME.csv
+  fi
+
   for ((i=0; i<$SMT_CONFIGURATIONS; i++)); do
     NTHREADS="${THREAD_COUNTS[i]}"
     SMTLVL="${SMT_SETTINGS[i]}"
@@ -65,29 +74,31 @@ for PREFETCH_SET in "${PREFETCHER_SETTINGS[@]}"; do
     fi
 
     FILENAME=benchmark-prefetch"$PREFETCH_SET"-smt"$SMTLVL"-thread"$NTHREADS"
-    EVENTS="cache-references,cache-misses,branches,branch-misses,task-clock,context-switches,cpu-migrations,page-faults,cycles,instructions"
+    # hardware counters are measured per sample by the benchmark itself, see --counters
     if $IS_POWER; then
 
-      perf stat --big-num -e "$EVENTS" \
-      --output "$FOLDER/$FILENAME-8bit-stats.txt" \
-      numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 8 > $FOLDER/$FILENAME-8bit-colstore.csv
+      numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 8 > $FOLDER/$FILENAME-8bit-colstore.csv
+
+      numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$FILENAME-64bit-colstore.csv
 
-      perf stat --big-num -e "$EVENTS" \
-      --output "$FOLDER/$FILENAME-64bit-stats.txt" \
-      numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$FILENAME-64bit-colstore.csv
+      #numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 8,16,32,64 > $FOLDER/$FILENAME-colstore.csv
 
-      #numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 8,16,32,64 > $FOLDER/$FILENAME-colstore.csv
+      #numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 10 --thread-count "$NTHREADS" --data-types 8,16,32,64 > $FOLDER/$FILENAME-rowstore.csv
 
-      #numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 10 --thread-count "$NTHREADS" --data-types 8,16,32,64 > $FOLDER/$FILENAME-rowstore.csv
+      numactl --cpunodebind=$CPUNODE benchmark/benchmark --mode join --placement node --memory-node $MEMNODE --thread-count "$NTHREADS" --data-types 32,64 > $FOLDER/$FILENAME-join.csv
+
+      numactl --cpunodebind=$CPUNODE benchmark/benchmark --mode prefetch --placement node --memory-node $MEMNODE --thread-count "$NTHREADS" --data-types 8,64 > $FOLDER/$FILENAME-prefetch.csv 2> $FOLDER/$FILENAME-prefetch-grid.txt
     else
       CPU="${CORE_BINDINGS[i]}"
-      perf stat --big-num -e "$EVENTS" \
-        --output "$FOLDER/$FILENAME-8bit-stats.txt" \
-        numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 8 > $FOLDER/$FILENAME-8bit.csv
+      benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 8 > $FOLDER/$FILENAME-8bit.csv
+
+      benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$FILENAME-64bit.csv
+
+      # build and probe phases of the npo and radix joins
+      benchmark/benchmark --mode join --cpus "$CPU" --placement node --memory-node $MEMNODE --thread-count "$NTHREADS" --data-types 32,64 > $FOLDER/$FILENAME-join.csv
 
-      perf stat --big-num -e "$EVENTS" \
-        --output "$FOLDER/$FILENAME-64bit-stats.txt" \
-        numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$FILENAME-64bit.csv
+      # software prefetching at every --prefetch-distance, the distance x size grid goes to stderr
+      benchmark/benchmark --mode prefetch --cpus "$CPU" --placement node --memory-node $MEMNODE --thread-count "$NTHREADS" --data-types 8,64 > $FOLDER/$FILENAME-prefetch.csv 2> $FOLDER/$FILENAME-prefetch-grid.txt
     fi
   done
 done
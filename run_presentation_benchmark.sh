@@ -46,21 +46,20 @@ if $IS_POWER; then
   ppc64_cpu --smt=1 # SMT 1
   ppc64_cpu --dscr=1 # no prefetching
   
-  numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-colstore.csv
-  numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-rowstore.csv
+  numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-colstore.csv
+  numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-rowstore.csv
 
 else
   CPU="${CORE_BINDINGS[0]}" # SMT 1
   benchmark/prefetching_intel -d # no prefetching
 
-  numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-colstore.csv
-  numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-rowstore.csv
+  benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-colstore.csv
+  benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 8 > $FOLDER/$DIR/$FILENAME-rowstore.csv
 fi
 
-# 2a) Datatype-picking: single threaded, no prefetching, colstore, all datatypes (perf stat)
+# 2a) Datatype-picking: single threaded, no prefetching, colstore, all datatypes (with hardware counters)
 DIR=2a
 mkdir -p "$FOLDER/$DIR/"
-EVENTS="cache-references,cache-misses,branches,branch-misses,task-clock,context-switches,cpu-migrations,page-faults,cycles,instructions"
 DATA_TYPES=(8 16 32 64)
 
 for DATA_TYPE in "${DATA_TYPES[@]}"; do
@@ -69,17 +68,13 @@ for DATA_TYPE in "${DATA_TYPES[@]}"; do
     ppc64_cpu --smt=1 # SMT 1
     ppc64_cpu --dscr=1 # no prefetching
 
-    perf stat -e "$EVENTS" \
-    --output "$FOLDER/$DIR/$FILENAME-stats.txt" \
-    numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types "$DATA_TYPE" > $FOLDER/$DIR/$FILENAME.csv
+    numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types "$DATA_TYPE" > $FOLDER/$DIR/$FILENAME.csv
 
   else
     CPU="${CORE_BINDINGS[0]}" # SMT 1
     benchmark/prefetching_intel -d # prefetching
 
-    perf stat -e "$EVENTS" \
-    --output "$FOLDER/$DIR/$FILENAME-stats.txt" \
-    numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types "$DATA_TYPE" > $FOLDER/$DIR/$FILENAME.csv
+    benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types "$DATA_TYPE" > $FOLDER/$DIR/$FILENAME.csv
   fi
 done
 
@@ -109,12 +104,12 @@ for PREFETCH_SET in "${PREFETCHER_SETTINGS[@]}"; do
 
   if $IS_POWER; then
     ppc64_cpu --smt=1 # SMT 1  
-    numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1  --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-colstore.csv
-    numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-rowstore.csv
+    numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1  --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-colstore.csv
+    numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-rowstore.csv
   else
     CPU="${CORE_BINDINGS[0]}" # SMT 1
-    numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1  --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-colstore.csv
-    numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-rowstore.csv
+    benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1  --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-colstore.csv
+    benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 10 --thread-count "${SINGLE_THREAD_COUNTS[0]}" --data-types 64 > $FOLDER/$DIR/$FILENAME-rowstore.csv
   fi
 done
 
@@ -133,10 +128,10 @@ for NTHREADS in "${SINGLE_THREAD_COUNTS[@]}"; do
   FILENAME=benchmark-prefetch1-smt1-thread"$NTHREADS"-64bit-colstore.csv
   if $IS_POWER; then
     ppc64_cpu --smt=1 # SMT 1  
-    numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
+    numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
   else
     CPU="${CORE_BINDINGS[0]}" # SMT 1
-    numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
+    benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
   fi
 done
 
@@ -159,10 +154,10 @@ for ((i=0; i<$SMT_CONFIGURATIONS; i++)); do
   FILENAME=benchmark-prefetch1-smt"$SMTLVL"-thread"$NTHREADS"-64bit-colstore.csv
   if $IS_POWER; then
     ppc64_cpu --smt="$SMTLVL" # set SMT level
-    numactl --cpunodebind=$CPUNODE --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
+    numactl --cpunodebind=$CPUNODE benchmark/benchmark --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
   else
     CPU="${CORE_BINDINGS[i]}" # set SMT level
-    numactl --physcpubind=$CPU --membind=$MEMNODE benchmark/benchmark --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
+    benchmark/benchmark --cpus "$CPU" --placement node --memory-node $MEMNODE --column-count 1 --thread-count "$NTHREADS" --data-types 64 > $FOLDER/$DIR/$FILENAME
   fi
 done
 